@@ -28,6 +28,10 @@ public:
 
     void clear_unchecked(const Square square) noexcept;
 
+    // Flipped top to bottom with the colours swapped, so white's pieces on rank 1 become
+    // black's on rank 8
+    Bitboard mirrored() const noexcept;
+
     std::uint64_t colour_mask(const Colour colour) const noexcept {
         return colours[colour];
     }
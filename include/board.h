@@ -4,9 +4,12 @@
 #include "castling.h"
 #include "decoded_move.h"
 #include "encoded_move.h"
+#include "zobrist.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
 // #include <vector>
 #include <array>
@@ -17,16 +20,24 @@ struct SavedMove {
     CastlingRights prev_castling;
     std::uint16_t prev_quiet_half_moves;
     std::optional<Square> prev_en_passant;
+    std::uint64_t prev_key;
 };
 
 class Board {
 public:
     static std::optional<Board> init(
         std::string_view fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    // The inverse of init, all 6 fields are always written
+    std::string to_fen() const;
 
     void make_move(const EncodedMove move);
     void make_move(const DecodedMove &move);
     void undo_last_move();
+    // Passes the turn to the other side without moving, for null move pruning. Positions from
+    // before the pass don't count for is_repetition. Undone with undo_null_move, not
+    // undo_last_move.
+    void make_null_move();
+    void undo_null_move();
 
     void operator()(const move_type_v::Quiet &quiet);
     void operator()(const move_type_v::Capture &cap);
@@ -42,6 +53,27 @@ public:
     Colour turn_colour() const { return turn_colour_; } 
     CastlingRights castling_rights() const { return castling_; }
     std::optional<Square> en_passant() const { return en_passant_; }
+    // half moves since the last capture or pawn move
+    std::uint8_t quiet_half_moves() const { return quiet_half_moves_; }
+    // Whether this position has come up before since the last capture or pawn move, as far
+    // back as the move history goes
+    bool is_repetition() const;
+    // Zobrist key of the position, kept up to date by make_move/undo_last_move
+    std::uint64_t key() const { return key_; }
+    // The same key worked out from scratch
+    std::uint64_t compute_key() const;
+
+    // The colour-flipped position: the board flipped top to bottom with the colours, castling
+    // rights and side to move swapped. Every line of play has a mirror image so the perft
+    // counts are the same. The clocks are kept and the move history isn't.
+    Board mirrored() const;
+    // mirrored().key() without building the board, the keys are laid out so it's a byteswap
+    std::uint64_t mirrored_key() const {
+        return direction::flip_vertical(key_) ^ zobrist::KEYS.black_to_move;
+    }
+    // The same for a position and its mirror, so tables keyed on it can share entries
+    // between the two
+    std::uint64_t canonical_key() const { return std::min(key_, mirrored_key()); }
 
 #ifndef FENRIR_TEST
 private:
@@ -51,6 +83,8 @@ private:
           const std::uint16_t quiet_half_moves, const Colour turn_colour,
           const CastlingRights castling, const std::optional<Square> en_passant);
 
+    std::uint64_t en_passant_key() const;
+
     Bitboard bitboard_; // 64 
     // Starts at 1 and increments after blacks move. Apparently the most moves in a game
     // of chess ever was 269 so best not to risk using a uint8_t
@@ -59,6 +93,7 @@ private:
     Colour turn_colour_ { WHITE };
     CastlingRights castling_ {};
     std::optional<Square> en_passant_ {};
+    std::uint64_t key_ {};
     // std::vector<SavedMove> prev_moves_;
     std::array<SavedMove, 256> prev_moves_ {};
     std::size_t back_ {};
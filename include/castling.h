@@ -20,6 +20,14 @@ public:
 
     void update_castling(const DecodedMove &move);
 
+    // the raw rights bitmask, for hashing
+    std::uint8_t rights() const { return castling; }
+
+    // white's rights become black's and vice versa
+    CastlingRights mirrored() const {
+        return CastlingRights(((castling & 0b0011) << 2) | ((castling & 0b1100) >> 2));
+    }
+
     void operator()(const move_type_v::Quiet &quiet);
     void operator()(const move_type_v::Capture &cap);
     void operator()(const move_type_v::CastleKingSide &cks);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "direction.h"
+#include "types.h"
+
+#include <cstdint>
+
+// Everything in move generation that differs between white and black, resolved at compile
+// time. Move generation is instantiated once per colour so none of these need a branch on
+// the side to move.
+
+namespace rank {
+
+constexpr std::uint64_t ONE   { 0x00000000000000FFul };
+constexpr std::uint64_t TWO   { ONE << 8 };
+constexpr std::uint64_t THREE { ONE << 16 };
+constexpr std::uint64_t FOUR  { ONE << 24 };
+constexpr std::uint64_t FIVE  { ONE << 32 };
+constexpr std::uint64_t SIX   { ONE << 40 };
+constexpr std::uint64_t SEVEN { ONE << 48 };
+constexpr std::uint64_t EIGHT { ONE << 56 };
+
+} // namespace rank
+
+template <Colour Us>
+struct ColourTraits {
+    static_assert(Us == WHITE || Us == BLACK);
+
+    static constexpr Colour them { opposite(Us) };
+
+    // a pawn move landing on this rank is a promotion
+    static constexpr std::uint64_t promotion_rank { Us == WHITE ? rank::EIGHT : rank::ONE };
+    // pawns that land here after a single push can push again
+    static constexpr std::uint64_t double_push_rank { Us == WHITE ? rank::THREE : rank::SIX };
+    // the rank our pawns capture en-passant onto
+    static constexpr std::uint64_t en_passant_rank { Us == WHITE ? rank::SIX : rank::THREE };
+
+    static constexpr Square king_start { Us == WHITE ? E1 : E8 };
+
+    static constexpr Square kingside_dest { Us == WHITE ? G1 : G8 };
+    static constexpr Square queenside_dest { Us == WHITE ? C1 : C8 };
+    static constexpr Square kingside_rook { Us == WHITE ? H1 : H8 };
+    static constexpr Square queenside_rook { Us == WHITE ? A1 : A8 };
+
+    // squares between the king and rook that must be empty
+    static constexpr std::uint64_t kingside_clear {
+        Us == WHITE ? from_square(F1) | from_square(G1)
+                    : from_square(F8) | from_square(G8)
+    };
+    static constexpr std::uint64_t queenside_clear {
+        Us == WHITE ? from_square(B1) | from_square(C1) | from_square(D1)
+                    : from_square(B8) | from_square(C8) | from_square(D8)
+    };
+    // squares the king passes through that must not be under attack
+    static constexpr std::uint64_t kingside_safe { kingside_clear };
+    static constexpr std::uint64_t queenside_safe {
+        Us == WHITE ? from_square(C1) | from_square(D1)
+                    : from_square(C8) | from_square(D8)
+    };
+
+    // one square towards the enemy back rank
+    static constexpr std::uint64_t push(const std::uint64_t mask) noexcept {
+        if constexpr (Us == WHITE) {
+            return direction::north(mask);
+        } else {
+            return direction::south(mask);
+        }
+    }
+
+    // squares our pawns on mask attack. Unlike the pawn attack table this is valid for every
+    // rank, so it can also be used from a target square to find the enemy pawns attacking it
+    static constexpr std::uint64_t pawn_attacks(const std::uint64_t mask) noexcept {
+        if constexpr (Us == WHITE) {
+            return direction::north_east(mask) | direction::north_west(mask);
+        } else {
+            return direction::south_east(mask) | direction::south_west(mask);
+        }
+    }
+
+    // one square towards our own back rank
+    static constexpr std::uint64_t push_back(const std::uint64_t mask) noexcept {
+        if constexpr (Us == WHITE) {
+            return direction::south(mask);
+        } else {
+            return direction::north(mask);
+        }
+    }
+};
@@ -99,4 +99,9 @@ constexpr std::uint64_t south_west_west(const std::uint64_t mask) {
     return (mask >> 10) & NOT_GH_FILE;
 }
 
+// rank 1 swaps with rank 8, rank 2 with rank 7 etc. One rank per byte so it's just a byteswap
+constexpr std::uint64_t flip_vertical(const std::uint64_t mask) noexcept {
+    return __builtin_bswap64(mask);
+}
+
 } // namespace direction
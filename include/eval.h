@@ -0,0 +1,20 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+
+class Board;
+
+namespace eval {
+
+inline constexpr std::array<int, NUM_PIECES> PIECE_VALUES {
+    100, 320, 330, 500, 900, 0
+};
+
+// Static evaluation in centipawns from the point of view of the side to move: material plus
+// piece-square tables, with the king's table blended from middlegame to endgame as the
+// pieces come off. The same for a position and its colour-flipped mirror.
+int evaluate(const Board &board);
+
+} // namespace eval
@@ -1,73 +1,179 @@
 #pragma once
 
+#include "attack_table.h"
+#include "bitboard.h"
+#include "board.h"
 #include "castling.h"
+#include "colour_traits.h"
 #include "encoded_move.h"
+#include "masks.h"
 #include "move_types.h"
+#include "set_bit_iterator.h"
 #include "types.h"
+#include "zone_profiler.h"
 
 #include <bit>
 #include "fenrir_assert.h"
+#include <concepts>
 #include <cstdint>
 #include <optional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
-class AttackTable;
-class Bitboard;
-class Board;
+// The colour templated versions are what the move generator uses internally, the
+// runtime colour versions just dispatch to them.
 
 // returns a mask of all pinned pieces
+template <Colour Us>
+std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at);
 std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at, const Colour colour);
 
 struct KingInfo {
     std::uint64_t king_danger_squares; // all squares under attack
-    std::uint64_t king_checking_pieces; 
+    std::uint64_t king_checking_pieces;
     // Squares friendly pieces can move to to block check or capture the checking piece.
     // If the number of checking pieces > 1 then this value is ignored for non-king pieces.
-    // If the checking piece is a non-sliding piece, then 
+    // If the checking piece is a non-sliding piece, then
     // king_check_blocking_squares will == king_checking_pieces, as pieces can only
     // intervene by capturing that piece
     std::uint64_t check_intervention_squares;
 };
 
+template <Colour Us>
+KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at);
 KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at, const Colour colour);
 
 // While the above function calculates all checking pieces, along with danger/intervention squares
-// sometimes we just want to know as efficiently as possible whether the king in check, e.g. for 
+// sometimes we just want to know as efficiently as possible whether the king in check, e.g. for
 // legality of en-passant moves
+template <Colour Us>
+bool king_in_check(const Bitboard &bb, const AttackTable &at);
 bool king_in_check(const Bitboard &bb, const AttackTable &at, const Colour colour);
 
+// all enemy pieces attacking the square, given the occupancy
+template <Colour Us>
+std::uint64_t enemy_attackers(const Bitboard &bb, const AttackTable &at, const Square square,
+                              const std::uint64_t occupied);
+
+// Just the checking pieces and intervention squares, king_danger_squares is left as 0.
+// Enough for pseudo-legal generation to only produce moves that deal with a check.
+template <Colour Us>
+KingInfo king_checkers(const Bitboard &bb, const AttackTable &at);
+
+enum class GenMode : std::uint8_t {
+    LEGAL,
+    // Pins, king steps into attack and en-passant discovered checks are left for
+    // legal_after_pseudo to catch, so only the moves that actually get searched pay for them.
+    // When in check only moves that capture/block the checker or move the king are generated,
+    // and castling is only generated when it's legal.
+    PSEUDO_LEGAL,
+    // Legal captures, en-passants and promotions only, for the quiescence search. When in
+    // check every evasion is generated so a mate can still be seen.
+    CAPTURES,
+};
+
+template <typename F>
+concept MoveSink = std::invocable<F&, EncodedMove>;
+
 class MoveGen {
 public:
-    MoveGen(std::vector<EncodedMove> &moves, Board &board, const AttackTable &at);
+    MoveGen(std::vector<EncodedMove> &moves, const Board &board, const AttackTable &at);
 
-    // Made rvalue to prevent mistakes with the object outliving its reference members
+    // Made rvalue to prevent mistakes with the object outliving its reference members.
     void gen() &&;
+    void gen_pseudo_legal() &&;
+    void gen_captures() &&;
+
+    // Streams every legal move to fn without storing them anywhere. If fn returns bool then
+    // returning false stops generation. Returns false if generation was stopped early.
+    // This is the only place the side to move is branched on, everything after it is
+    // instantiated per colour.
+    template <GenMode Mode = GenMode::LEGAL, MoveSink F>
+    static bool for_each(const Board &board, const AttackTable &at, F &&fn);
 private:
-    MoveGen(std::vector<EncodedMove> &moves, Bitboard &bb, const AttackTable &at,
-            const Colour friendly_colour, CastlingRights castling, std::optional<Square> en_passant,
-            const KingInfo &king_info);
+    std::vector<EncodedMove> &moves;
+    const Board &board;
+    const AttackTable &at;
+};
 
-    void push_if_legal(const MoveType type, const std::uint64_t source, const std::uint64_t dest, 
+bool has_legal_move(const Board &board, const AttackTable &at);
+std::optional<EncodedMove> first_legal_move(const Board &board, const AttackTable &at);
+
+enum class MateStatus : std::uint8_t {
+    NONE,
+    CHECKMATE,
+    STALEMATE,
+};
+
+MateStatus mate_status(const Board &board, const AttackTable &at);
+
+// Checks a single move, e.g. a hash or killer move, against the position without generating
+// every move. is_pseudo_legal checks the move could be made in this position ignoring whether
+// it leaves the king in check, is_legal additionally checks the king is safe afterwards.
+// Moves must match what the generator would produce exactly, including the captured piece.
+bool is_pseudo_legal(const Board &board, const AttackTable &at, const EncodedMove move);
+bool is_legal(const Board &board, const AttackTable &at, const EncodedMove move);
+
+// The legality check for a move from GenMode::PSEUDO_LEGAL generation, meant to be run just
+// before the move is made. Only en-passant, king moves and moves by a piece in line with its
+// own king can be illegal at that point.
+bool legal_after_pseudo(const Board &board, const AttackTable &at, const EncodedMove move);
+
+// The generator proper, instantiated per side to move. Every legal move is handed to the sink
+// as it's found rather than being collected here. A sink returning bool can stop generation
+// early by returning false, a sink returning void sees every move.
+template <Colour Us, GenMode Mode, typename Sink>
+class ColourMoveGen {
+public:
+    ColourMoveGen(Sink &sink, const Bitboard &bb, const AttackTable &at,
+                  CastlingRights castling, std::optional<Square> en_passant,
+                  const KingInfo &king_info);
+
+    // returns false if the sink stopped generation early
+    bool gen();
+private:
+    using Traits = ColourTraits<Us>;
+    static constexpr Colour Them { Traits::them };
+    static constexpr bool can_stop {
+        std::is_same_v<std::invoke_result_t<Sink&, EncodedMove>, bool>
+    };
+
+    void emit(const EncodedMove move);
+    bool done() const {
+        if constexpr (can_stop) {
+            return stopped;
+        } else {
+            return false;
+        }
+    }
+
+    static bool in_line_with_king(const std::uint64_t source, const std::uint64_t dest,
+                                  const std::uint64_t king_pos);
+
+    void push_if_legal(const MoveType type, const std::uint64_t source, const std::uint64_t dest,
                        const Piece piece, const Piece captured_piece, const Piece promoted_piece);
+    bool en_passant_is_legal(const std::uint64_t source, const std::uint64_t dest) const;
 
     void escape_single_check();
     void generate_pawn_moves();
     void single_pawn_moves(const std::uint64_t single_pawn);
-    void single_pawn_captures(const std::uint64_t single_pawn, const std::uint64_t captures, 
-                              const Piece capturable, const Colour enemy_colour);
+    void single_pawn_captures(const std::uint64_t single_pawn, const std::uint64_t captures,
+                              const Piece capturable);
     void single_pawn_quiet_moves(const std::uint64_t single_pawn, std::uint64_t quiet_moves);
+    std::uint64_t pawn_quiet_moves(const std::uint64_t single_pawn) const;
     void captures_for_piece_type(const Piece piece_type);
     void captures_for_single_piece(const Piece piece_type, const std::uint64_t single_src_piece);
     void quiet_moves_for_piece_type(const Piece piece_type);
 
     void king_moves();
-    void castling(const Piece side);
+    template <Piece Side>
+    void castling();
+    bool path_attacked(const std::uint64_t path) const;
 
-    std::vector<EncodedMove> &moves;
-    Bitboard &bb;
+    Sink &sink;
+    const Bitboard &bb;
     const AttackTable &at;
-    const Colour friendly_colour;
     CastlingRights castling_rights;
     std::optional<Square> en_passant;
 
@@ -75,4 +181,506 @@ private:
     const std::uint64_t danger_squares {};
     const std::uint64_t checking_pieces {};
     const std::uint64_t check_intervention_squares {};
+
+    bool stopped {};
 };
+
+template <GenMode Mode, MoveSink F>
+bool MoveGen::for_each(const Board &board, const AttackTable &at, F &&fn) {
+    const Bitboard &bb { board.bitboard() };
+    if (board.turn_colour() == WHITE) {
+        return ColourMoveGen<WHITE, Mode, std::remove_reference_t<F>>(
+            fn, bb, at, board.castling_rights(), board.en_passant(),
+            Mode == GenMode::PSEUDO_LEGAL ? king_checkers<WHITE>(bb, at)
+                                          : king_danger_squares<WHITE>(bb, at)
+        ).gen();
+    } else {
+        return ColourMoveGen<BLACK, Mode, std::remove_reference_t<F>>(
+            fn, bb, at, board.castling_rights(), board.en_passant(),
+            Mode == GenMode::PSEUDO_LEGAL ? king_checkers<BLACK>(bb, at)
+                                          : king_danger_squares<BLACK>(bb, at)
+        ).gen();
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+ColourMoveGen<Us, Mode, Sink>::ColourMoveGen(Sink &sink,
+                                       const Bitboard &bb,
+                                       const AttackTable &at,
+                                       CastlingRights castling,
+                                       std::optional<Square> en_passant,
+                                       const KingInfo &king_info) :
+        sink(sink),
+        bb(bb),
+        at(at),
+        castling_rights(castling),
+        en_passant(en_passant),
+        pinned(Mode == GenMode::PSEUDO_LEGAL ? 0ul : pinned_pieces<Us>(bb, at)),
+        danger_squares(king_info.king_danger_squares),
+        checking_pieces(king_info.king_checking_pieces),
+        check_intervention_squares(king_info.check_intervention_squares)
+{}
+
+template <Colour Us, GenMode Mode, typename Sink>
+bool ColourMoveGen<Us, Mode, Sink>::gen() {
+    // If in check by more than 1 piece, the only way to get out of it is to move
+    // the king
+    if (std::popcount(checking_pieces) > 1) {
+        king_moves();
+        return !done();
+
+    } else if (std::popcount(checking_pieces) == 1) {
+        escape_single_check();
+        return !done();
+    }
+
+    // Not in check
+
+    if constexpr (Mode != GenMode::CAPTURES) {
+        castling<KING>();
+        castling<QUEEN>();
+    }
+
+    generate_pawn_moves();
+
+    for (const auto piece_type : NORMAL_PIECES) {
+        captures_for_piece_type(piece_type);
+    }
+
+    if constexpr (Mode != GenMode::CAPTURES) {
+        for (const auto piece_type : NORMAL_PIECES) {
+            quiet_moves_for_piece_type(piece_type);
+        }
+    }
+
+    king_moves();
+    return !done();
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::emit(const EncodedMove move) {
+    if constexpr (can_stop) {
+        if (!stopped) {
+            stopped = !sink(move);
+        }
+    } else {
+        sink(move);
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+bool ColourMoveGen<Us, Mode, Sink>::in_line_with_king(const std::uint64_t source,
+                                                const std::uint64_t dest,
+                                                const std::uint64_t king_pos) {
+    return direction::SOURCE_DEST_MASKS[from_mask(king_pos)][from_mask(source)] & dest;
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::push_if_legal(
+    const MoveType type, const std::uint64_t source, const std::uint64_t dest,
+    const Piece piece, const Piece captured_piece, const Piece promoted_piece
+) {
+    if constexpr (Mode == GenMode::PSEUDO_LEGAL) {
+        emit(EncodedMove(type,
+                         from_mask(source),
+                         from_mask(dest),
+                         piece,
+                         Us,
+                         captured_piece,
+                         promoted_piece));
+        return;
+    }
+
+    if (type == MoveType::EN_PASSANT) {
+        if (en_passant_is_legal(source, dest)) {
+            emit(EncodedMove(type,
+                             from_mask(source),
+                             from_mask(dest),
+                             piece,
+                             Us,
+                             captured_piece,
+                             promoted_piece));
+        }
+        return;
+    }
+
+    if (!(source & pinned) ||
+        in_line_with_king(source, dest, bb.colour_piece_mask(Us, KING))
+    ) {
+        emit(EncodedMove(type,
+                         from_mask(source),
+                         from_mask(dest),
+                         piece,
+                         Us,
+                         captured_piece,
+                         promoted_piece));
+    }
+}
+
+// En-passant removes two pieces from the same rank so it can uncover a check the pin
+// calculation doesn't see, and it can also capture the checking pawn. Rather than make and
+// unmake the move we recompute the occupancy the move leaves behind and look for any enemy
+// piece that attacks the king through it.
+template <Colour Us, GenMode Mode, typename Sink>
+bool ColourMoveGen<Us, Mode, Sink>::en_passant_is_legal(const std::uint64_t source,
+                                            const std::uint64_t dest) const {
+    BOOST_ASSERT(dest & Traits::en_passant_rank);
+    const std::uint64_t captured_pawn { Traits::push_back(dest) };
+    const std::uint64_t occupied { (bb.entire_mask() ^ source ^ captured_pawn) | dest };
+    const Square king_sq { from_mask(bb.colour_piece_mask(Us, KING)) };
+    const std::uint64_t enemy_queens { bb.colour_piece_mask(Them, QUEEN) };
+
+    const std::uint64_t rook_attackers {
+        at.attacks(king_sq, ROOK, Us, occupied) &
+        (bb.colour_piece_mask(Them, ROOK) | enemy_queens)
+    };
+    const std::uint64_t bishop_attackers {
+        at.attacks(king_sq, BISHOP, Us, occupied) &
+        (bb.colour_piece_mask(Them, BISHOP) | enemy_queens)
+    };
+    const std::uint64_t knight_attackers {
+        at.attacks(king_sq, KNIGHT, Us, occupied) & bb.colour_piece_mask(Them, KNIGHT)
+    };
+    const std::uint64_t pawn_attackers {
+        Traits::pawn_attacks(from_square(king_sq)) &
+        (bb.colour_piece_mask(Them, PAWN) ^ captured_pawn)
+    };
+    return !(rook_attackers | bishop_attackers | knight_attackers | pawn_attackers);
+}
+
+/* if there's only a single checker, the options are:
+* 1. Capture the checking piece
+* 2. A non-king piece blocking the check (if the checker is a sliding piece)
+* 3. Move the king */
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::escape_single_check() {
+    FENRIR_ZONE(CHECK_EVASIONS);
+    // captures of checking piece
+    for (const auto piece_type : NON_KING_PIECES) {
+        const auto all_src_pieces { bb.colour_piece_mask(Us, piece_type) };
+        for (const auto single_src_piece : SetBits(all_src_pieces)) {
+            if (done()) {
+                return;
+            }
+            const std::uint64_t ep_mask {
+                (en_passant && piece_type == PAWN ? from_square(*en_passant) : 0ul)
+            };
+            const std::uint64_t enemy_mask {
+                bb.colour_mask(Them) | ep_mask
+            };
+            const auto captures {
+                at.captures(from_mask(single_src_piece), piece_type, Us,
+                            bb.entire_mask(), enemy_mask)
+            };
+            const auto captures_of_checking_piece {
+                captures & check_intervention_squares
+            };
+            if (captures_of_checking_piece) {
+                const auto checking_piece { bb.square_occupant(from_mask(checking_pieces)) };
+                BOOST_ASSERT(checking_piece.has_value());
+                BOOST_ASSERT(checking_piece->first == Them);
+                if (piece_type == PAWN) {
+                    single_pawn_captures(single_src_piece, captures_of_checking_piece,
+                                         checking_piece->second);
+                } else {
+                    push_if_legal(MoveType::CAPTURE, single_src_piece, checking_pieces, piece_type,
+                                checking_piece->second, NUM_PIECES);
+                }
+            }
+            // push_if_legal will check if the en-passant is legal
+            if (captures & ep_mask) {
+                push_if_legal(MoveType::EN_PASSANT, single_src_piece, ep_mask, PAWN,
+                              PAWN, NUM_PIECES);
+            }
+        }
+    }
+
+    // blocks
+    for (const auto piece_type : NON_KING_PIECES) {
+        const auto all_src_pieces { bb.colour_piece_mask(Us, piece_type) };
+        for (const auto single_src_piece : SetBits(all_src_pieces)) {
+            if (done()) {
+                return;
+            }
+            if (piece_type == PAWN) {
+                single_pawn_quiet_moves(
+                    single_src_piece,
+                    pawn_quiet_moves(single_src_piece) & check_intervention_squares
+                );
+            } else {
+                const auto blocks {
+                    at.moves_(from_mask(single_src_piece), piece_type, Us, bb.entire_mask())
+                    & check_intervention_squares
+                };
+                for (const auto dest : SetBits(blocks)) {
+                    push_if_legal(MoveType::QUIET, single_src_piece, dest, piece_type,
+                                NUM_PIECES, NUM_PIECES);
+                }
+            }
+        }
+    }
+
+    king_moves();
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::king_moves() {
+    FENRIR_ZONE(KING_MOVES);
+    const Square king_sq { from_mask(bb.colour_piece_mask(Us, KING)) };
+    const std::uint64_t blockers { bb.entire_mask() };
+    std::uint64_t king_attacks {
+        at.attacks(king_sq, KING, Us, blockers)
+    };
+    king_attacks &= ~bb.colour_mask(Us);
+    king_attacks &= ~danger_squares;
+
+    if (king_attacks == 0) {
+        return;
+    }
+
+    EncodedMove template_move(
+        MoveType::CAPTURE,
+        king_sq,
+        NUM_SQUARES, // dest square, to be filled in
+        KING,
+        Us,
+        NUM_PIECES, // captured piece, to be filled in
+        NUM_PIECES
+    );
+
+    for (const auto capturable : CAPTURABLE_PIECES) {
+        template_move.captured_piece = static_cast<std::uint32_t>(capturable);
+        const std::uint64_t captures_of_piece {
+            bb.colour_piece_mask(Them, capturable) & king_attacks
+        };
+        king_attacks ^= captures_of_piece;
+        for (const auto capture_of_piece : SetBits(captures_of_piece)) {
+            template_move.dest_square = static_cast<std::uint32_t>(from_mask(capture_of_piece));
+            emit(template_move);
+        }
+    }
+
+    if constexpr (Mode == GenMode::CAPTURES) {
+        if (!checking_pieces) {
+            return;
+        }
+    }
+
+    // all remaining moves are quiet moves
+    template_move.move_type = static_cast<std::uint32_t>(MoveType::QUIET);
+    template_move.captured_piece = static_cast<std::uint32_t>(NUM_PIECES);
+    for (const auto quiet_move : SetBits(king_attacks)) {
+        template_move.dest_square = static_cast<std::uint32_t>(from_mask(quiet_move));
+        emit(template_move);
+    }
+}
+
+// We invalidate castling if the king/rook ever moves, so all we need to check is
+// if the path is clear and whether the intermediate squares are under attack.
+// This means things fall over if the castling rights we pass in are incorrect, we
+// assume if castling is allowed the king/rook are on their original squares.
+template <Colour Us, GenMode Mode, typename Sink>
+template <Piece Side>
+void ColourMoveGen<Us, Mode, Sink>::castling() {
+    FENRIR_ZONE(CASTLING);
+    static_assert(Side == KING || Side == QUEEN);
+
+    if (!castling_rights.can_castle(Us, Side)) {
+        return;
+    }
+
+    constexpr std::uint64_t required_clear_squares {
+        Side == KING ? Traits::kingside_clear : Traits::queenside_clear
+    };
+    constexpr std::uint64_t required_no_incoming_attack_squares {
+        Side == KING ? Traits::kingside_safe : Traits::queenside_safe
+    };
+    constexpr Square dest_sq { Side == KING ? Traits::kingside_dest : Traits::queenside_dest };
+    constexpr auto type { Side == KING ? MoveType::CASTLE_KINGSIDE : MoveType::CASTLE_QUEENSIDE };
+
+    // check the king hasn't moved
+    BOOST_ASSERT(from_mask(bb.colour_piece_mask(Us, KING)) == Traits::king_start);
+    // check the rook hasn't moved
+    BOOST_ASSERT(bb.colour_piece_mask(Us, ROOK) &
+                 from_square(Side == KING ? Traits::kingside_rook : Traits::queenside_rook));
+
+    //     are the intermediate squares blocked?
+    if ( !(required_clear_squares & bb.entire_mask() ||
+           // are the intermediate squares under attack?
+           path_attacked(required_no_incoming_attack_squares)) ) {
+        emit(EncodedMove(type,
+                         Traits::king_start,
+                         dest_sq,
+                         KING,
+                         Us,
+                         NUM_PIECES,
+                         NUM_PIECES));
+    }
+}
+
+// Pseudo-legal generation doesn't have the danger squares so has to look at each square
+template <Colour Us, GenMode Mode, typename Sink>
+bool ColourMoveGen<Us, Mode, Sink>::path_attacked(const std::uint64_t path) const {
+    if constexpr (Mode != GenMode::PSEUDO_LEGAL) {
+        return path & danger_squares;
+    } else {
+        const std::uint64_t occupied { bb.entire_mask() };
+        for (const auto square : SetBits(path)) {
+            if (enemy_attackers<Us>(bb, at, from_mask(square), occupied)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::quiet_moves_for_piece_type(const Piece piece_type) {
+    FENRIR_ZONE(QUIET_MOVES);
+    const std::uint64_t all_pieces { bb.entire_mask() };
+    const std::uint64_t all_src_pieces { bb.colour_piece_mask(Us, piece_type) };
+    for (const std::uint64_t single_src_piece : SetBits(all_src_pieces)) {
+        if (done()) {
+            return;
+        }
+        const std::uint64_t quiet_moves {
+            at.moves_(from_mask(single_src_piece), piece_type, Us, all_pieces)
+        };
+        for (const auto single_move : SetBits(quiet_moves)) {
+            push_if_legal(MoveType::QUIET, single_src_piece, single_move, piece_type,
+                          NUM_PIECES, NUM_PIECES);
+        }
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::captures_for_piece_type(const Piece piece_type) {
+    FENRIR_ZONE(PIECE_CAPTURES);
+    const std::uint64_t all_src_pieces { bb.colour_piece_mask(Us, piece_type) };
+    for (const std::uint64_t single_src_piece : SetBits(all_src_pieces)) {
+        if (done()) {
+            return;
+        }
+        captures_for_single_piece(piece_type, single_src_piece);
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::captures_for_single_piece(
+    const Piece piece_type, const std::uint64_t single_src_piece
+) {
+    const std::uint64_t enemy_pieces_mask { bb.colour_mask(Them) };
+    const std::uint64_t all_pieces { bb.entire_mask() };
+
+    const std::uint64_t captures {
+        at.captures(from_mask(single_src_piece), piece_type, Us,
+                                all_pieces, enemy_pieces_mask)
+    };
+
+    if (captures == 0) {
+        return;
+    }
+
+    for (const Piece capturable_piece : CAPTURABLE_PIECES) {
+        const std::uint64_t captures_of_piece {
+            captures & bb.colour_piece_mask(Them, capturable_piece)
+        };
+        for (const auto single_capture : SetBits(captures_of_piece)) {
+            push_if_legal(MoveType::CAPTURE, single_src_piece, single_capture,
+                          piece_type, capturable_piece, NUM_PIECES);
+        }
+    }
+}
+
+// Single and double pushes are just shifts towards the enemy back rank, a double push
+// needs both the square in front and the destination to be empty
+template <Colour Us, GenMode Mode, typename Sink>
+std::uint64_t ColourMoveGen<Us, Mode, Sink>::pawn_quiet_moves(const std::uint64_t single_pawn) const {
+    const std::uint64_t empty { ~bb.entire_mask() };
+    const std::uint64_t single_push { Traits::push(single_pawn) & empty };
+    const std::uint64_t double_push {
+        Traits::push(single_push & Traits::double_push_rank) & empty
+    };
+    return single_push | double_push;
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::single_pawn_quiet_moves(
+    const std::uint64_t single_pawn, std::uint64_t quiet_moves
+) {
+    BOOST_ASSERT(std::popcount(quiet_moves) <= 2);
+    for (const auto single_move : SetBits(quiet_moves)) {
+        if (single_move & Traits::promotion_rank) {
+            for (const auto promotion_piece : PROMOTION_PIECES) {
+                push_if_legal(MoveType::MOVE_PROMOTION, single_pawn, single_move, PAWN,
+                              NUM_PIECES, promotion_piece);
+            }
+        } else {
+            const auto type {
+                single_move == Traits::push(Traits::push(single_pawn)) ? MoveType::DOUBLE_PAWN_PUSH
+                                                                       : MoveType::QUIET
+            };
+            push_if_legal(type, single_pawn, single_move, PAWN, NUM_PIECES, NUM_PIECES);
+        }
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::single_pawn_captures(const std::uint64_t single_pawn,
+                                             const std::uint64_t captures,
+                                             const Piece capturable) {
+    const auto captures_of_piece { captures & bb.colour_piece_mask(Them, capturable) };
+    for (const auto single_capture : SetBits(captures_of_piece)) {
+        if (single_capture & Traits::promotion_rank) {
+            for (const auto promotion_piece : PROMOTION_PIECES) {
+                push_if_legal(MoveType::CAPTURE_PROMOTION, single_pawn, single_capture,
+                              PAWN, capturable, promotion_piece);
+            }
+        } else {
+            push_if_legal(MoveType::CAPTURE, single_pawn, single_capture, PAWN,
+                          capturable, NUM_PIECES);
+        }
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::single_pawn_moves(const std::uint64_t single_pawn) {
+    const std::uint64_t ep_mask { en_passant ? from_square(*en_passant) : 0ul };
+    const std::uint64_t enemy_pieces_mask { bb.colour_mask(Them) | ep_mask };
+    const std::uint64_t captures {
+        at.captures(from_mask(single_pawn), PAWN, Us, 0ul, enemy_pieces_mask) };
+    BOOST_ASSERT(std::popcount(captures) <= 2);
+
+    if (captures > 0) {
+        for (const auto capturable : CAPTURABLE_PIECES) {
+            single_pawn_captures(single_pawn, captures, capturable);
+        }
+    }
+
+    const std::uint64_t ep_captures { ep_mask & captures };
+    if (ep_captures > 0) {
+        BOOST_ASSERT(std::popcount(ep_captures) == 1);
+        push_if_legal(MoveType::EN_PASSANT, single_pawn, ep_mask, PAWN, PAWN, NUM_PIECES);
+    }
+
+    std::uint64_t quiet_moves { pawn_quiet_moves(single_pawn) };
+    if constexpr (Mode == GenMode::CAPTURES) {
+        quiet_moves &= Traits::promotion_rank;
+    }
+
+    if (quiet_moves > 0) {
+        single_pawn_quiet_moves(single_pawn, quiet_moves);
+    }
+}
+
+template <Colour Us, GenMode Mode, typename Sink>
+void ColourMoveGen<Us, Mode, Sink>::generate_pawn_moves() {
+    FENRIR_ZONE(PAWN_MOVES);
+    const std::uint64_t all_pawns { bb.colour_piece_mask(Us, PAWN) };
+    for (const auto single_pawn : SetBits(all_pawns)) {
+        if (done()) {
+            return;
+        }
+        single_pawn_moves(single_pawn);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "encoded_move.h"
+#include "transposition_table.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+inline bool is_quiet(const EncodedMove move) {
+    return move.captured_piece >= NUM_PIECES && move.promoted_piece >= NUM_PIECES;
+}
+
+// Most valuable victim first, then least valuable attacker. A promotion counts the piece it
+// promotes to as a victim.
+int mvv_lva(const EncodedMove move);
+
+// Hands out moves best score first. Each next() is one step of a selection sort done in
+// place, so when an early move causes a cutoff the rest never get sorted.
+class MovePicker {
+public:
+    MovePicker(std::vector<EncodedMove> &moves, std::vector<int> &scores) :
+        moves(moves),
+        scores(scores)
+    {}
+
+    std::optional<EncodedMove> next() {
+        if (current == moves.size()) {
+            return std::nullopt;
+        }
+        std::size_t best { current };
+        for (std::size_t i = current + 1; i < moves.size(); ++i) {
+            if (scores[i] > scores[best]) {
+                best = i;
+            }
+        }
+        std::swap(moves[current], moves[best]);
+        std::swap(scores[current], scores[best]);
+        return moves[current++];
+    }
+
+private:
+    std::vector<EncodedMove> &moves;
+    std::vector<int> &scores;
+    std::size_t current {};
+};
+
+// The quiet move ordering heuristics, one set per search thread: two killer moves per ply,
+// a butterfly history table of from/to squares per colour and a countermove per previous
+// move's piece and destination.
+class MoveOrdering {
+public:
+    explicit MoveOrdering(const int max_ply);
+
+    void clear();
+
+    // Scores moves for a MovePicker. The hash move comes first, then captures and promotions
+    // by MVV-LVA, then the killers, then the countermove to previous, then the rest of the
+    // quiets by history.
+    void score(const std::vector<EncodedMove> &moves, std::vector<int> &scores, const int ply,
+               const PackedMove hash_move, const std::optional<EncodedMove> previous) const;
+
+    // A quiet move caused a cutoff, it becomes a killer and previous's countermove, and its
+    // history goes up while the history of the quiets tried before it goes down
+    void quiet_cutoff(const EncodedMove move, const std::span<const EncodedMove> tried,
+                      const int ply, const int depth, const std::optional<EncodedMove> previous);
+
+    int history_score(const EncodedMove move) const {
+        return history[move.colour][move.source_square][move.dest_square];
+    }
+
+    // The killers from the last time a node at ply was searched come from a different part of
+    // the tree, so the killers are cleared for the children before a node's moves are searched
+    void clear_killers(const int ply) { killers[ply] = {}; }
+
+    // history entries are kept within +-MAX_HISTORY
+    static constexpr int MAX_HISTORY { 16384 };
+
+private:
+    void add_history(const EncodedMove move, const int bonus);
+
+    std::vector<std::array<PackedMove, 2>> killers;
+    std::array<std::array<std::array<int, NUM_SQUARES>, NUM_SQUARES>, 2> history {};
+    std::array<std::array<std::array<PackedMove, NUM_SQUARES>, NUM_PIECES>, 2> countermoves {};
+};
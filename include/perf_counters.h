@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+// Hardware performance counters for this process (and any threads it starts) through Linux's
+// perf_event_open, for telling whether a change helped with cache misses or branch misses
+// rather than just the time. Kernel time isn't counted.
+//
+// Each counter is opened separately, so a machine or VM that only has some of them still gets
+// those. Without any (not Linux, no PMU, perf_event_paranoid too high) everything still works
+// and the sample is just empty.
+
+enum class PerfEvent : std::uint8_t {
+    CYCLES,
+    INSTRUCTIONS,
+    BRANCH_MISSES,
+    L1D_MISSES,
+    LLC_MISSES,
+};
+
+inline constexpr std::size_t NUM_PERF_EVENTS { 5 };
+
+struct PerfSample {
+    // std::nullopt if the counter couldn't be opened or never got scheduled
+    std::array<std::optional<std::uint64_t>, NUM_PERF_EVENTS> counts;
+
+    std::optional<std::uint64_t> operator[](const PerfEvent event) const {
+        return counts[static_cast<std::size_t>(event)];
+    }
+    // instructions per cycle
+    std::optional<double> ipc() const;
+};
+
+class PerfCounters {
+public:
+    // opens whatever counters are available, none of them counting yet
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    // why the first counter that couldn't be opened wasn't, empty if they all were
+    const std::string& error() const { return error_; }
+
+    // zeroes the counters and starts them
+    void start();
+    // stops the counters and reads them. Counts are scaled up if the kernel had to share the
+    // hardware between more events than it has counters for.
+    PerfSample stop();
+
+private:
+    std::array<int, NUM_PERF_EVENTS> fds_;
+    std::string error_;
+};
+
+inline constexpr const char* perf_event_name(const PerfEvent event) {
+    switch (event) {
+        case PerfEvent::CYCLES:        return "cycles";
+        case PerfEvent::INSTRUCTIONS:  return "instructions";
+        case PerfEvent::BRANCH_MISSES: return "branch misses";
+        case PerfEvent::L1D_MISSES:    return "L1D misses";
+        case PerfEvent::LLC_MISSES:    return "LLC misses";
+    }
+    return "";
+}
+
+// A table of every counter, with the count per node alongside if nodes isn't 0
+void print_perf_sample(std::ostream &out, const PerfSample &sample, const std::uint64_t nodes);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "move_gen.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class AttackTable;
+class Board;
+class PerftProgress;
+class PerftTable;
+
+// Counts the leaf nodes depth plies below board. board is left as it was found. Leaves are
+// also added to progress as they're counted, if there is one.
+std::uint64_t perft(Board &board, const AttackTable &at, const int depth,
+                    const GenMode mode = GenMode::LEGAL, PerftProgress *progress = nullptr);
+
+// Same count, with subtree counts cached in table. With canonical set entries are keyed on
+// Board::canonical_key so a position and its colour-flipped mirror share one.
+std::uint64_t perft(Board &board, const AttackTable &at, const int depth, PerftTable &table,
+                    const bool canonical, const GenMode mode = GenMode::LEGAL,
+                    PerftProgress *progress = nullptr);
+
+// The breakdown published alongside perft node counts. Every field counts moves made at one
+// ply, so nodes is the perft count at that depth. As in the published tables a double check
+// isn't also counted as a discovered check.
+struct PerftStats {
+    std::uint64_t nodes;
+    std::uint64_t captures;
+    std::uint64_t en_passants;
+    std::uint64_t castles;
+    std::uint64_t promotions;
+    std::uint64_t checks;
+    std::uint64_t discovered_checks;
+    std::uint64_t double_checks;
+    std::uint64_t checkmates;
+
+    PerftStats& operator+=(const PerftStats &other);
+    friend bool operator==(const PerftStats&, const PerftStats&) = default;
+};
+
+// Classifies a single legal move from board into stats. board is only modified if the move
+// gives check, to look for mate, and is left as it was found.
+void count_move_stats(Board &board, const AttackTable &at, const EncodedMove move,
+                      PerftStats &stats);
+
+// Stats for every ply from board down to depth, in a single walk of the tree. by_ply[0] gets
+// the moves from board itself, so by_ply needs at least depth entries.
+void perft_stats(Board &board, const AttackTable &at, const int depth,
+                 std::span<PerftStats> by_ply);
+
+// "legal" or "pseudo", as taken on the command line
+std::optional<GenMode> parse_gen_mode(std::string_view name);
+
+// A position from an EPD perft suite, in the usual format of a FEN followed by the expected
+// counts, e.g. "<fen> ;D1 20 ;D2 400". A line with no counts is just a FEN.
+struct EpdEntry {
+    std::string fen;
+    // (depth, expected node count), in the order they appear
+    std::vector<std::pair<int, std::uint64_t>> expected;
+};
+
+// Returns std::nullopt if the line is malformed. Blank lines and # comments should be
+// skipped by the caller.
+std::optional<EpdEntry> parse_epd_line(std::string_view line);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Subtotals of finished perft subtrees, keyed by the moves from the root to the subtree
+// separated by spaces, e.g. "e2e4 e7e5". Appended to a file as each one finishes so a long run
+// can be picked up again after being interrupted.
+//
+// The file starts with a header line identifying the run (depth, position and moves), and a
+// checkpoint is only resumed if its header matches.
+class PerftCheckpoint {
+public:
+    // Starts a new checkpoint file, or with resume set, picks up the subtotals in an existing
+    // one. Returns std::nullopt if the file can't be opened or belongs to a different run.
+    static std::optional<PerftCheckpoint> open(const std::string &path,
+                                               const std::string &header, const bool resume);
+
+    std::optional<std::uint64_t> find(const std::string &key) const;
+    // Written and flushed straight away
+    void record(const std::string &key, const std::uint64_t nodes);
+
+    std::size_t size() const { return done.size(); }
+private:
+    PerftCheckpoint() = default;
+
+    std::unordered_map<std::string, std::uint64_t> done;
+    std::ofstream file;
+};
+
+// Reads the subtotals from a checkpoint. Returns std::nullopt if the header doesn't match. A
+// malformed last line, e.g. from being killed mid-write, is ignored.
+std::optional<std::unordered_map<std::string, std::uint64_t>> load_checkpoint(
+    std::istream &in, std::string_view header);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <span>
+#include <thread>
+
+// Nodes counted so far by one perft thread. The thread adds to a plain counter and only
+// publishes it to the atomic every PUBLISH_EVERY nodes, so the hot loop never touches shared
+// memory. Readers on other threads see a slightly stale count.
+class alignas(64) PerftProgress {
+public:
+    void add(const std::uint64_t nodes) {
+        local_ += nodes;
+        if (local_ - last_published_ >= PUBLISH_EVERY) {
+            publish();
+        }
+    }
+
+    // makes the exact count visible, e.g. once a subtree is finished
+    void publish() {
+        last_published_ = local_;
+        published_.store(local_, std::memory_order_relaxed);
+    }
+
+    std::uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+    static constexpr std::uint64_t PUBLISH_EVERY { 1u << 20 };
+private:
+    std::uint64_t local_ {};
+    std::uint64_t last_published_ {};
+    std::atomic<std::uint64_t> published_ {};
+};
+
+// Prints a progress line to out every interval while a perft run is going: nodes so far,
+// the node rate over the last interval and overall, and an estimate of the time left.
+//
+// The estimate assumes the root moves still to go have as many nodes on average as the ones
+// that have finished, so there isn't one until the first root move is done.
+class ProgressReporter {
+public:
+    ProgressReporter(std::span<const PerftProgress> counters, const std::size_t root_moves,
+                     const std::chrono::milliseconds interval, std::ostream &out);
+    // stops the reporting thread
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    // Called as each root move's subtree finishes, with its count. Any counters that went
+    // into it should have been published first.
+    void root_move_done(const std::uint64_t nodes);
+
+private:
+    void run();
+    void report(const std::chrono::steady_clock::time_point now);
+    std::uint64_t counted() const;
+
+    std::span<const PerftProgress> counters_;
+    const std::size_t root_moves_;
+    const std::chrono::milliseconds interval_;
+    std::ostream &out_;
+    const std::chrono::steady_clock::time_point start_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ {};
+    // guarded by mutex_
+    std::size_t finished_moves_ {};
+    std::uint64_t finished_nodes_ {};
+    // counted() when the last root move finished, anything past it is the moves in progress
+    std::uint64_t counted_at_finish_ {};
+
+    // only touched by the reporting thread
+    std::uint64_t last_counted_ {};
+    std::chrono::steady_clock::time_point last_report_;
+
+    std::thread thread_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// A cache of perft subtree counts keyed by position key and depth. It's lossy, each bucket
+// keeps the deepest subtree it's seen plus whatever was stored most recently, so a probe can
+// miss something that was stored but never returns the wrong count (short of a 64 bit key
+// collision).
+class PerftTable {
+public:
+    // Rounded down to a power of two number of buckets, always at least one
+    explicit PerftTable(const std::size_t bytes);
+
+    std::optional<std::uint64_t> probe(const std::uint64_t key, const int depth);
+    void store(const std::uint64_t key, const int depth, const std::uint64_t nodes);
+
+    std::uint64_t probes() const { return probes_; }
+    std::uint64_t hits() const { return hits_; }
+    std::size_t size_bytes() const { return buckets_.size() * sizeof(Bucket); }
+
+private:
+    // the low byte of data is the depth and the rest the count, a depth of 0 is an empty slot
+    struct Entry {
+        std::uint64_t key;
+        std::uint64_t data;
+
+        int depth() const { return static_cast<int>(data & 0xFF); }
+        std::uint64_t nodes() const { return data >> 8; }
+    };
+    struct Bucket {
+        Entry deepest;
+        Entry recent;
+    };
+
+    Bucket& bucket(const std::uint64_t key) { return buckets_[key & mask_]; }
+
+    std::vector<Bucket> buckets_;
+    std::uint64_t mask_ {};
+    std::uint64_t probes_ {};
+    std::uint64_t hits_ {};
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "attack_table.h"
+#include "board.h"
+#include "encoded_move.h"
+#include "transposition_table.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace score {
+
+inline constexpr int INFINITE { 32000 };
+// mate at the root, mate n plies from the root scores MATE - n
+inline constexpr int MATE { 31000 };
+inline constexpr int MAX_PLY { 128 };
+
+inline constexpr bool is_mate(const int score) {
+    return score >= MATE - MAX_PLY || score <= -(MATE - MAX_PLY);
+}
+
+// "cp <centipawns>" or "mate <moves>", negative if the side to move is getting mated, as UCI
+// reports it
+std::string to_string(const int score);
+
+} // namespace score
+
+// Any limit left at 0 isn't applied. The first iteration always finishes, so there's always a
+// move to play.
+struct SearchLimits {
+    int depth {};
+    std::uint64_t nodes {};
+    std::chrono::milliseconds time {};
+};
+
+struct IterationInfo {
+    int depth;
+    int score;
+    std::uint64_t nodes;
+    std::chrono::milliseconds elapsed;
+    std::vector<EncodedMove> pv;
+    // permille of the transposition table in use
+    int hashfull;
+
+    std::uint64_t nps() const;
+};
+
+// Counts for judging how well the search prunes and orders its moves
+struct SearchStats {
+    // nodes in the quiescence search
+    std::uint64_t qnodes {};
+    // captures the quiescence search skipped without making them because SEE said they lose
+    // material
+    std::uint64_t see_pruned {};
+    // fail highs outside the quiescence search, and how many came from the first move tried.
+    // With perfect ordering every one would.
+    std::uint64_t cutoffs {};
+    std::uint64_t first_move_cutoffs {};
+    // nodes cut off by null move pruning, these aren't in cutoffs
+    std::uint64_t null_cutoffs {};
+    // late moves searched to a reduced depth, how many of them had to be searched again in
+    // full, and how many weren't searched at all
+    std::uint64_t reductions {};
+    std::uint64_t lmr_re_searches {};
+    std::uint64_t late_moves_pruned {};
+    // zero window searches that beat alpha and had to be searched again with the full window
+    std::uint64_t pvs_re_searches {};
+    // iterations that fell outside their aspiration window and were searched again
+    std::uint64_t aspiration_fail_lows {};
+    std::uint64_t aspiration_fail_highs {};
+
+    SearchStats& operator+=(const SearchStats &other);
+    double first_move_cutoff_rate() const;
+};
+
+struct SearchResult {
+    // std::nullopt if there are no legal moves
+    std::optional<EncodedMove> best_move;
+    int score;
+    // the deepest iteration that finished
+    int depth;
+    std::uint64_t nodes;
+    // from every thread
+    SearchStats stats;
+    std::vector<EncodedMove> pv;
+};
+
+// How more than one search thread splits up the work
+enum class ParallelMode {
+    // every thread searches the whole tree, helpers at staggered depths, and they only help
+    // each other through the transposition table
+    LAZY_SMP,
+    // every thread searches the same depth, but a move another thread is already searching is
+    // put off until the node's other moves are done
+    ABDADA,
+};
+
+std::optional<ParallelMode> parse_parallel_mode(std::string_view name);
+std::string_view parallel_mode_name(const ParallelMode mode);
+
+// Negamax alpha-beta with iterative deepening. Each iteration searches the previous
+// iteration's best move first. Draws by repetition and the fifty move rule score 0.
+//
+// With more than one thread every thread runs its own iterative deepening on its own copy of
+// the board, sharing the transposition table, the stop flag and the node count, and the
+// ParallelMode decides how they avoid duplicating each other's work. The main thread applies
+// the limits and reports the iterations.
+class Search {
+public:
+    Search(const AttackTable &at, TranspositionTable &tt, const unsigned threads = 1,
+           const ParallelMode mode = ParallelMode::LAZY_SMP);
+    ~Search();
+
+    using IterationCallback = std::function<void(const IterationInfo&)>;
+
+    // Neither while a search is running
+    void set_threads(const unsigned threads);
+    unsigned threads() const { return static_cast<unsigned>(workers.size()); }
+    void set_parallel_mode(const ParallelMode parallel_mode) { mode = parallel_mode; }
+    ParallelMode parallel_mode() const { return mode; }
+
+    // board is left as it was found. on_iteration is called as each of the main thread's
+    // iterations finishes. The result is from whichever thread got deepest, the best score
+    // breaking ties.
+    SearchResult run(Board &board, const SearchLimits &limits,
+                     const IterationCallback &on_iteration = {});
+
+    // Makes a running search return as soon as it can, safe to call from another thread
+    void stop() { stop_requested.store(true, std::memory_order_relaxed); }
+    // While pondering the node and time limits aren't applied, so the search carries on until
+    // it's stopped or pondering's turned off, after which they're applied as usual, the time
+    // still counted from when the search started. Safe to call from another thread.
+    void set_pondering(const bool on) { pondering.store(on, std::memory_order_relaxed); }
+
+private:
+    // one search thread's own state
+    class Worker;
+
+    const AttackTable &at;
+    TranspositionTable &tt;
+    std::atomic<bool> stop_requested {};
+    std::atomic<bool> pondering {};
+    // every thread's nodes, each adds its own in batches
+    std::atomic<std::uint64_t> total_nodes {};
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point start;
+    ParallelMode mode;
+    // ABDADA's table of the moves being searched right now, each slot holds the hash of a
+    // position and move, 0 when it's free. Collisions only cost a move being deferred when it
+    // didn't need to be or searched twice.
+    std::vector<std::atomic<std::uint64_t>> searching;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+};
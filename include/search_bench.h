@@ -0,0 +1,25 @@
+#pragma once
+
+#include "search.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+struct SearchBenchOptions {
+    // every thread count is run with each mode, the first run is what the others are compared
+    // against
+    std::vector<ParallelMode> modes;
+    std::vector<unsigned> threads;
+    int depth;
+    std::size_t hash_mb;
+};
+
+// 1, 2, 4, ... up to max_threads, with max_threads itself on the end if it isn't a power of 2
+std::vector<unsigned> doubling_thread_counts(const unsigned max_threads);
+
+// Searches a fixed set of positions to options.depth with each mode and thread count, from a
+// cleared table each time, and prints the time to depth, nodes and NPS for each next to how
+// they scale from the first run, along with the effective branching factor of the last
+// iteration.
+void search_bench(std::ostream &out, const AttackTable &at, const SearchBenchOptions &options);
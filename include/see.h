@@ -0,0 +1,17 @@
+#pragma once
+
+#include "encoded_move.h"
+
+class AttackTable;
+class Board;
+
+// Static exchange evaluation: the material the side to move comes out of the exchange on the
+// move's destination with, in centipawns, if both sides keep recapturing with their least
+// valuable piece for as long as it pays. Sliders lined up behind other attackers join in as
+// the pieces in front of them are used up. Pins and checks are ignored, apart from a king
+// never recapturing onto a defended square.
+int see(const Board &board, const AttackTable &at, const EncodedMove move);
+
+// see(board, at, move) >= threshold, but it can stop as soon as the answer's known
+bool see_ge(const Board &board, const AttackTable &at, const EncodedMove move,
+            const int threshold);
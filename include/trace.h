@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+// A timeline of what every thread was doing, written out as Chrome trace-event JSON that
+// opens in Perfetto (ui.perfetto.dev) or chrome://tracing. Meant for seeing load imbalance
+// and idle time in the multithreaded tools.
+//
+// Each thread records into its own fixed size ring buffer, so recording never takes a lock
+// or touches another thread's memory. If a thread records more than a buffer holds the oldest
+// events are overwritten, and the ends of scopes whose begins went with them are left out of
+// the JSON. Until enable() is called a trace::Scope is just a relaxed load and a branch.
+//
+// Names and categories must be string literals (or otherwise outlive the trace), only the
+// pointer is stored.
+
+namespace trace {
+
+inline std::atomic<bool> recording {};
+
+inline bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+// Starts recording, timestamps are relative to the first call
+void enable();
+// Stops recording, what's been recorded so far is kept
+void disable();
+// Drops everything recorded so far. No thread should be recording while this runs.
+void clear();
+
+// Shown in place of the thread id in the viewer. Only has any effect while enabled.
+void set_thread_name(std::string name);
+
+// phase is 'B' (begin), 'E' (end) or 'i' (instant). arg_name can be nullptr for no argument.
+void record(const char *name, const char *category, const char phase,
+            const char *arg_name = nullptr, const std::uint64_t arg = 0);
+
+// Every thread's events so far. Threads should have finished recording, an event being
+// written while this runs can come out torn.
+void write_json(std::ostream &out);
+// Prints an error and returns false if the file can't be written
+bool write_json(const std::string &path);
+
+// Events lost to full ring buffers
+std::uint64_t dropped();
+
+// A tool's --trace. With a path it starts recording, naming the calling thread, and the trace
+// is written there by finish(), or when it goes out of scope if finish() was never called.
+// Without a path it does nothing.
+class Output {
+public:
+    explicit Output(std::optional<std::string> path, std::string thread_name = "main");
+    ~Output();
+
+    // Writes the trace, and returns exit_code, or 1 if the trace couldn't be written
+    int finish(const int exit_code);
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+private:
+    std::optional<std::string> path;
+};
+
+// A begin event now and the matching end event when it goes out of scope
+class Scope {
+public:
+    Scope(const char *name, const char *category,
+          const char *arg_name = nullptr, const std::uint64_t arg = 0)
+        :   name(name), category(category), active(enabled())
+    {
+        if (active) [[unlikely]] {
+            record(name, category, 'B', arg_name, arg);
+        }
+    }
+    ~Scope() {
+        if (active) [[unlikely]] {
+            record(name, category, 'E');
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    const char *name;
+    const char *category;
+    const bool active;
+};
+
+} // namespace trace
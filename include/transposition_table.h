@@ -0,0 +1,81 @@
+#pragma once
+
+#include "encoded_move.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// A move cut down to its source, destination and promotion piece, which is enough to pick it
+// back out of the generated moves. 0 is no move, a1a1 can't be one.
+using PackedMove = std::uint16_t;
+
+PackedMove pack_move(const EncodedMove move);
+bool matches(const PackedMove packed, const EncodedMove move);
+
+// What the stored score says about the real one
+enum class Bound : std::uint8_t {
+    NONE,
+    // the real score is at most this, nothing got above alpha
+    UPPER,
+    // at least this, it failed high
+    LOWER,
+    EXACT,
+};
+
+struct TTEntry {
+    PackedMove move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// Shared by every search thread without any locking. Each 64 byte bucket holds 4 entries of two
+// words, the packed data and the key XORed with it. Two threads writing the same entry at once
+// can leave one's key word next to the other's data, but then the XOR no longer gives back the
+// key and the probe just misses, so a torn entry is never returned.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(const std::size_t mb = 16, const unsigned threads = 1);
+
+    // Throws away everything stored. Rounded down to a power of two number of buckets, always
+    // at least one.
+    void resize(const std::size_t mb, const unsigned threads = 1);
+    // Splits the zeroing between threads, it's most of the time spent on a large table
+    void clear(const unsigned threads = 1);
+    // Call before each search, entries from older searches are replaced first
+    void new_search() { generation_ = (generation_ + 1) & GENERATION_MASK; }
+
+    std::optional<TTEntry> probe(const std::uint64_t key) const;
+    // Scores are stored as given, mate scores need making relative to the node first
+    void store(const std::uint64_t key, const PackedMove move, const int score, const int depth,
+               const Bound bound);
+
+    // Permille of a sample of entries that were written during the current search
+    int hashfull() const;
+    std::size_t size_mb() const { return mb_; }
+
+private:
+    static constexpr std::size_t ENTRIES_PER_BUCKET { 4 };
+    static constexpr std::uint8_t GENERATION_MASK { 0x3F };
+
+    // only ever accessed through std::atomic_ref, so the table can be zeroed with memset
+    struct Slot {
+        std::uint64_t check;
+        std::uint64_t data;
+    };
+    struct alignas(64) Bucket {
+        std::array<Slot, ENTRIES_PER_BUCKET> slots;
+    };
+    static_assert(sizeof(Bucket) == 64);
+
+    const Bucket& bucket(const std::uint64_t key) const { return buckets_[key & mask_]; }
+    Bucket& bucket(const std::uint64_t key) { return buckets_[key & mask_]; }
+
+    std::unique_ptr<Bucket[]> buckets_;
+    std::size_t count_ {};
+    std::uint64_t mask_ {};
+    std::size_t mb_ {};
+    std::uint8_t generation_ {};
+};
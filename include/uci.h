@@ -0,0 +1,95 @@
+#pragma once
+
+#include "attack_table.h"
+#include "board.h"
+#include "encoded_move.h"
+#include "search.h"
+#include "transposition_table.h"
+#include "types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// The arguments to "go"
+struct GoCommand {
+    // depth, nodes and movetime
+    SearchLimits limits;
+    // wtime/btime and winc/binc, indexed by colour
+    std::array<std::chrono::milliseconds, 2> time {};
+    std::array<std::chrono::milliseconds, 2> increment {};
+    int moves_to_go {};
+    bool infinite {};
+    bool ponder {};
+};
+
+// std::nullopt if there's an unknown argument or a value's missing or not a number
+std::optional<GoCommand> parse_go(std::string_view args);
+
+// go's depth, nodes and movetime, and if there was no movetime but there's a clock for the side
+// to move, a share of what's left on it
+SearchLimits search_limits(const GoCommand &go, const Colour colour);
+
+// A UCI engine. Commands are handled on the thread that calls handle(), searches run on a
+// thread of their own, and everything sent goes through a queue to a writer thread, so a slow
+// reader on the other end never holds up the search. stop, ponderhit and isready are answered
+// while a search is running. Other commands that change the engine's state wait for it to stop
+// first.
+class Uci {
+public:
+    Uci(const AttackTable &at, std::ostream &out, const std::size_t hash_mb = 16,
+        const unsigned threads = 1);
+    ~Uci();
+
+    // Handles lines from in until "quit" or the end of the input
+    void run(std::istream &in);
+    // false once it's "quit"
+    bool handle(std::string_view line);
+    // Blocks until the search that's running, if there is one, has sent its bestmove. An
+    // infinite or ponder search needs a stop or ponderhit from another thread first.
+    void wait();
+
+private:
+    void uci();
+    void set_option(std::string_view args);
+    void position(std::string_view args);
+    void go(std::string_view args);
+    // stops the search that's running, if there is one, and waits for it to finish
+    void stop_search();
+    void release_bestmove();
+    // Plays a move of the game, moving it onto a new board when the history's getting long
+    void play(const EncodedMove move);
+    void send(std::string line);
+
+    const AttackTable &at;
+    TranspositionTable tt;
+    Search search;
+    Board board;
+    // since board was set up, Board only keeps so many moves of history and the search needs
+    // room for its own
+    std::vector<EncodedMove> game;
+
+    std::jthread search_thread;
+    // set by stop, the search is told again after each iteration in case the stop came before
+    // it had started
+    std::atomic<bool> stopping {};
+    // an infinite or ponder search keeps its bestmove until it's stopped or the ponder hits
+    std::atomic<bool> hold_bestmove {};
+    bool infinite {};
+
+    std::mutex output_mutex;
+    std::condition_variable output_ready;
+    std::deque<std::string> output;
+    bool output_done {};
+    std::jthread writer;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class AttackTable;
+class Board;
+
+// A set of position keys split into shards by the top bits of the key, each shard with its own
+// lock. When a shard fills the memory it's been given it's sorted and written to disk as a run
+// and emptied. Since a shard only ever holds keys from its own range, counting at the end only
+// has to merge each shard's runs with each other.
+class SpillingKeySet {
+public:
+    SpillingKeySet(const std::size_t memory_budget, std::filesystem::path spill_dir);
+    ~SpillingKeySet();
+
+    SpillingKeySet(const SpillingKeySet&) = delete;
+    SpillingKeySet& operator=(const SpillingKeySet&) = delete;
+
+    // Takes a batch so each shard's lock is only taken once per batch. keys gets reordered.
+    void insert(std::span<std::uint64_t> keys);
+
+    // The number of distinct keys inserted, merging anything that's been spilled. Only valid
+    // once every insert has finished.
+    std::uint64_t count();
+
+    std::size_t runs() const { return run_count.load(); }
+
+    static constexpr int SHARD_BITS { 6 };
+    static constexpr std::size_t NUM_SHARDS { 1u << SHARD_BITS };
+private:
+    // open addressing with linear probing, 0 marks an empty slot so the key 0 is kept aside
+    struct Shard {
+        std::mutex mutex;
+        std::vector<std::uint64_t> table;
+        std::size_t size {};
+        bool has_zero {};
+        std::vector<std::filesystem::path> runs;
+    };
+
+    static std::size_t shard_of(const std::uint64_t key) { return key >> (64 - SHARD_BITS); }
+
+    void insert_locked(Shard &shard, const std::uint64_t key);
+    // sorts the shard's keys and writes them out, leaving it empty
+    void spill(Shard &shard, const std::size_t index);
+    std::vector<std::uint64_t> take_sorted(Shard &shard);
+
+    std::array<Shard, NUM_SHARDS> shards;
+    std::size_t shard_capacity;
+    std::filesystem::path spill_dir;
+    std::atomic<std::size_t> run_count {};
+};
+
+struct UniqueCount {
+    // same as perft, every path to depth
+    std::uint64_t paths;
+    // distinct positions among them
+    std::uint64_t unique;
+    std::size_t spilled_runs;
+};
+
+// Counts the distinct positions depth plies below board, by their keys. The root moves are
+// shared out between threads.
+UniqueCount count_unique_positions(const Board &board, const AttackTable &at, const int depth,
+                                   const unsigned threads, const std::size_t memory_budget,
+                                   const std::filesystem::path &spill_dir);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "direction.h"
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+
+// Random keys for hashing positions, XORed together for every piece on the board plus the
+// side to move, castling rights and en-passant file. Generated at compile time from a fixed
+// seed so keys are the same from run to run.
+//
+// The keys are laid out so that byteswapping a key gives the key of the colour-flipped
+// position (see Board::mirrored_key): a black piece's key is the byteswapped key of the white
+// piece on the mirrored square, black's castling rights are white's byteswapped, and the
+// en-passant and side to move keys read the same byteswapped.
+
+namespace zobrist {
+
+constexpr std::uint64_t splitmix64(std::uint64_t &state) {
+    std::uint64_t z { state += 0x9E3779B97F4A7C15ul };
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ul;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBul;
+    return z ^ (z >> 31);
+}
+
+struct Keys {
+    std::array<std::array<std::array<std::uint64_t, NUM_SQUARES>, NUM_PIECES>, NUM_COLOURS>
+        pieces;
+    // indexed by the castling rights bitmask
+    std::array<std::uint64_t, 16> castling;
+    std::array<std::uint64_t, 8> en_passant_file;
+    std::uint64_t black_to_move;
+};
+
+// the same bytes forwards and backwards, so it's unchanged by a byteswap
+constexpr std::uint64_t palindromic(std::uint64_t &state) {
+    const std::uint64_t half { splitmix64(state) >> 32 };
+    return half | direction::flip_vertical(half);
+}
+
+constexpr Keys generate_keys() {
+    Keys keys {};
+    std::uint64_t state { 0x46454E524952ul }; // "FENRIR"
+    for (auto &piece : keys.pieces[WHITE]) {
+        for (auto &square : piece) {
+            square = splitmix64(state);
+        }
+    }
+    for (std::size_t piece = 0; piece < NUM_PIECES; ++piece) {
+        for (std::size_t square = 0; square < NUM_SQUARES; ++square) {
+            keys.pieces[BLACK][piece][square] =
+                direction::flip_vertical(keys.pieces[WHITE][piece][square ^ 56]);
+        }
+    }
+    // each right gets its own key and a set of rights is the XOR of them, so updating the key
+    // only needs the rights that changed. Bits 0-1 are white's, 2-3 black's
+    std::array<std::uint64_t, 4> rights {};
+    rights[0] = splitmix64(state);
+    rights[1] = splitmix64(state);
+    rights[2] = direction::flip_vertical(rights[0]);
+    rights[3] = direction::flip_vertical(rights[1]);
+    for (std::size_t mask = 0; mask < keys.castling.size(); ++mask) {
+        for (std::size_t i = 0; i < rights.size(); ++i) {
+            if (mask & (1u << i)) {
+                keys.castling[mask] ^= rights[i];
+            }
+        }
+    }
+    // a mirrored ep square is on the same file
+    for (auto &file : keys.en_passant_file) {
+        file = palindromic(state);
+    }
+    keys.black_to_move = palindromic(state);
+    return keys;
+}
+
+inline constexpr Keys KEYS { generate_keys() };
+
+inline constexpr std::uint64_t piece(const Colour colour, const Piece piece,
+                                     const Square square) {
+    return KEYS.pieces[colour][piece][square];
+}
+
+} // namespace zobrist
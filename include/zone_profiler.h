@@ -0,0 +1,90 @@
+#pragma once
+
+// FENRIR_ZONE(NAME) times the rest of the enclosing scope with the CPU's timestamp counter and
+// adds it to the NAME zone, e.g. FENRIR_ZONE(PINS). Outside of FENRIR_PROFILING builds it
+// compiles to nothing.
+//
+// Each thread adds into its own counters, which are merged when the thread exits. A table of
+// every zone sorted by total cycles is printed to stderr when the program exits. Zones can
+// nest, an outer zone's cycles include the inner zone's.
+
+#ifdef FENRIR_PROFILING
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace profiling {
+
+enum class Zone : std::uint8_t {
+    KING_DANGER,
+    PINS,
+    CHECK_EVASIONS,
+    PAWN_MOVES,
+    PIECE_CAPTURES,
+    QUIET_MOVES,
+    KING_MOVES,
+    CASTLING,
+    MAKE_MOVE,
+    UNDO_MOVE,
+};
+
+inline constexpr std::size_t NUM_ZONES { 10 };
+
+struct ZoneTotals {
+    std::uint64_t cycles;
+    std::uint64_t calls;
+};
+
+// Plain thread_local data so the hot path has no initialisation guard to check
+inline thread_local std::array<ZoneTotals, NUM_ZONES> thread_totals {};
+inline thread_local bool thread_registered {};
+
+// Arranges for this thread's totals to be merged in when it exits
+void register_thread();
+
+inline std::uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+class ScopedZone {
+public:
+    explicit ScopedZone(const Zone zone) : zone(zone), start(read_cycles()) {}
+    ~ScopedZone() {
+        ZoneTotals &totals { thread_totals[static_cast<std::size_t>(zone)] };
+        totals.cycles += read_cycles() - start;
+        ++totals.calls;
+        if (!thread_registered) [[unlikely]] {
+            register_thread();
+        }
+    }
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+private:
+    const Zone zone;
+    const std::uint64_t start;
+};
+
+} // namespace profiling
+
+#define FENRIR_ZONE_CONCAT_(a, b) a##b
+#define FENRIR_ZONE_CONCAT(a, b) FENRIR_ZONE_CONCAT_(a, b)
+#define FENRIR_ZONE(name) \
+    const ::profiling::ScopedZone FENRIR_ZONE_CONCAT(fenrir_zone_, __LINE__) { \
+        ::profiling::Zone::name \
+    }
+
+#else
+
+#define FENRIR_ZONE(name) static_cast<void>(0)
+
+#endif
@@ -1,4 +1,5 @@
 #include "bitboard.h"
+#include "direction.h"
 #include "utility.h"
 
 #include <algorithm>
@@ -280,6 +281,16 @@ void Bitboard::operator()(const move_type_v::CapturePromotion cp, move_action_v:
     place_unchecked(opposite(cp.common.colour), cp.captured_piece, cp.common.dest);
 }
 
+Bitboard Bitboard::mirrored() const noexcept {
+    Bitboard mirror {};
+    mirror.colours[WHITE] = direction::flip_vertical(colours[BLACK]);
+    mirror.colours[BLACK] = direction::flip_vertical(colours[WHITE]);
+    for (std::size_t piece = 0; piece < pieces.size(); ++piece) {
+        mirror.pieces[piece] = direction::flip_vertical(pieces[piece]);
+    }
+    return mirror;
+}
+
 bool operator==(const Bitboard &a, const Bitboard &b) {
     return a.colours == b.colours && a.pieces == b.pieces;
 }
@@ -1,7 +1,11 @@
 #include "board.h"
 #include "castling.h"
+#include "colour_traits.h"
+#include "set_bit_iterator.h"
 #include "utility.h"
 #include "types.h"
+#include "zobrist.h"
+#include "zone_profiler.h"
 
 #include <iostream>
 #include <limits>
@@ -19,6 +23,62 @@ Board::Board(const Bitboard &bb, const std::uint16_t fullmove_count,
         en_passant_(en_passant)
 {
     // prev_moves_.reserve(256);
+    key_ = compute_key();
+}
+
+// Only included when a pawn could actually take en-passant, so a double push nothing can take
+// hashes the same as any other move to the same position
+std::uint64_t Board::en_passant_key() const {
+    if (!en_passant_.has_value()) {
+        return 0;
+    }
+    const std::uint64_t ep_square { from_square(*en_passant_) };
+    // the squares the side to move would need a pawn on to capture onto the ep square
+    const std::uint64_t capturers {
+        turn_colour_ == WHITE ? ColourTraits<BLACK>::pawn_attacks(ep_square)
+                              : ColourTraits<WHITE>::pawn_attacks(ep_square)
+    };
+    if (!(capturers & bitboard_.colour_piece_mask(turn_colour_, PAWN))) {
+        return 0;
+    }
+    return zobrist::KEYS.en_passant_file[*en_passant_ % 8];
+}
+
+std::uint64_t Board::compute_key() const {
+    std::uint64_t key {};
+    for (const auto colour : { WHITE, BLACK }) {
+        for (const auto piece : ALL_PIECES) {
+            for (const auto mask : SetBits(bitboard_.colour_piece_mask(colour, piece))) {
+                key ^= zobrist::piece(colour, piece, from_mask(mask));
+            }
+        }
+    }
+    key ^= zobrist::KEYS.castling[castling_.rights()];
+    key ^= en_passant_key();
+    if (turn_colour_ == BLACK) {
+        key ^= zobrist::KEYS.black_to_move;
+    }
+    return key;
+}
+
+bool Board::is_repetition() const {
+    // the same side has to be to move, and it takes at least 4 plies to get back to a position
+    const std::size_t limit { std::min<std::size_t>(quiet_half_moves_, back_) };
+    for (std::size_t plies = 4; plies <= limit; plies += 2) {
+        if (prev_moves_[back_ - plies].prev_key == key_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Board Board::mirrored() const {
+    std::optional<Square> en_passant {};
+    if (en_passant_.has_value()) {
+        en_passant = static_cast<Square>(*en_passant_ ^ 56);
+    }
+    return Board { bitboard_.mirrored(), fullmove_count_, quiet_half_moves_,
+                   opposite(turn_colour_), castling_.mirrored(), en_passant };
 }
 
 void Board::make_move(const EncodedMove move) {
@@ -26,15 +86,20 @@ void Board::make_move(const EncodedMove move) {
 }
 
 void Board::make_move(const DecodedMove &move) {
+    FENRIR_ZONE(MAKE_MOVE);
     // needs to be done before making the move as some of these values will get clobbered
     BOOST_ASSERT(back_ < prev_moves_.size());
     prev_moves_[back_++] = SavedMove {
         move,
         castling_,
         quiet_half_moves_,
-        en_passant_
+        en_passant_,
+        key_
     };
 
+    // the pieces are hashed by the visitor, everything else is swapped out here
+    key_ ^= zobrist::KEYS.castling[castling_.rights()] ^ en_passant_key();
+
     bitboard_.make_move(move);
 
     en_passant_ = std::nullopt;
@@ -47,9 +112,13 @@ void Board::make_move(const DecodedMove &move) {
     fullmove_count_ += turn_colour_;
 
     turn_colour_ = opposite(turn_colour_);
+
+    key_ ^= zobrist::KEYS.castling[castling_.rights()] ^ en_passant_key() ^
+            zobrist::KEYS.black_to_move;
 }
 
 void Board::undo_last_move() {
+    FENRIR_ZONE(UNDO_MOVE);
     // BOOST_ASSERT(!prev_moves_.empty());
     BOOST_ASSERT(back_ > 0);
     back_ -= 1;
@@ -57,6 +126,7 @@ void Board::undo_last_move() {
     castling_ = last_move.prev_castling;
     quiet_half_moves_ = last_move.prev_quiet_half_moves;
     en_passant_ = last_move.prev_en_passant;
+    key_ = last_move.prev_key;
 
     turn_colour_ = opposite(turn_colour_);
     fullmove_count_ -= turn_colour_;
@@ -64,7 +134,45 @@ void Board::undo_last_move() {
     bitboard_.unmake_move(last_move.move);
 }
 
+void Board::make_null_move() {
+    BOOST_ASSERT(back_ < prev_moves_.size());
+    // the saved move is never unmade, only the rest of the state is needed
+    prev_moves_[back_++] = SavedMove {
+        {},
+        castling_,
+        quiet_half_moves_,
+        en_passant_,
+        key_
+    };
+    key_ ^= en_passant_key();
+    en_passant_ = std::nullopt;
+    // a position either side of the pass isn't a real repetition
+    quiet_half_moves_ = 0;
+    fullmove_count_ += turn_colour_;
+    turn_colour_ = opposite(turn_colour_);
+    key_ ^= zobrist::KEYS.black_to_move;
+}
+
+void Board::undo_null_move() {
+    BOOST_ASSERT(back_ > 0);
+    back_ -= 1;
+    const auto &last_move { prev_moves_[back_] };
+    quiet_half_moves_ = last_move.prev_quiet_half_moves;
+    en_passant_ = last_move.prev_en_passant;
+    key_ = last_move.prev_key;
+
+    turn_colour_ = opposite(turn_colour_);
+    fullmove_count_ -= turn_colour_;
+}
+
+// the key of a piece moving from its source to its dest
+static std::uint64_t move_key(const move_type_v::Common &common) {
+    return zobrist::piece(common.colour, common.piece, common.source) ^
+           zobrist::piece(common.colour, common.piece, common.dest);
+}
+
 void Board::operator()(const move_type_v::Quiet &quiet) {
+    key_ ^= move_key(quiet.common);
     if (quiet.common.piece != PAWN) {
         quiet_half_moves_ += 1;
     } else {
@@ -72,32 +180,53 @@ void Board::operator()(const move_type_v::Quiet &quiet) {
     }
 }
 
-void Board::operator()(const move_type_v::Capture &) {
+void Board::operator()(const move_type_v::Capture &cap) {
+    key_ ^= move_key(cap.common) ^
+            zobrist::piece(opposite(cap.common.colour), cap.captured_piece, cap.common.dest);
     quiet_half_moves_ = 0;
 }
 
 void Board::operator()(const move_type_v::DoublePawnPush &dpp) {
+    key_ ^= move_key(dpp.common);
     quiet_half_moves_ = 0;
     en_passant_ = dpp.ep_square;
 }
 
-void Board::operator()(const move_type_v::CastleKingSide &) {
+void Board::operator()(const move_type_v::CastleKingSide &cks) {
+    // the rook goes from the corner to the other side of the king
+    const Colour colour { cks.common.colour };
+    key_ ^= move_key(cks.common) ^
+            zobrist::piece(colour, ROOK, static_cast<Square>(cks.common.dest + 1)) ^
+            zobrist::piece(colour, ROOK, static_cast<Square>(cks.common.dest - 1));
     quiet_half_moves_ += 1;
 }
 
-void Board::operator()(const move_type_v::CastleQueenSide &) {
+void Board::operator()(const move_type_v::CastleQueenSide &cqs) {
+    const Colour colour { cqs.common.colour };
+    key_ ^= move_key(cqs.common) ^
+            zobrist::piece(colour, ROOK, static_cast<Square>(cqs.common.dest - 2)) ^
+            zobrist::piece(colour, ROOK, static_cast<Square>(cqs.common.dest + 1));
     quiet_half_moves_ += 1;
 }
 
-void Board::operator()(const move_type_v::EnPassant &) {
+void Board::operator()(const move_type_v::EnPassant &ep) {
+    key_ ^= move_key(ep.common) ^
+            zobrist::piece(opposite(ep.common.colour), PAWN, ep.pawn_square);
     quiet_half_moves_ = 0;
 }
 
-void Board::operator()(const move_type_v::MovePromotion &) {
+void Board::operator()(const move_type_v::MovePromotion &mp) {
+    const auto &common { mp.common };
+    key_ ^= zobrist::piece(common.colour, PAWN, common.source) ^
+            zobrist::piece(common.colour, mp.promotion_piece, common.dest);
     quiet_half_moves_ = 0;
 }
 
-void Board::operator()(const move_type_v::CapturePromotion &) {
+void Board::operator()(const move_type_v::CapturePromotion &cp) {
+    const auto &common { cp.common };
+    key_ ^= zobrist::piece(common.colour, PAWN, common.source) ^
+            zobrist::piece(common.colour, cp.promotion_piece, common.dest) ^
+            zobrist::piece(opposite(common.colour), cp.captured_piece, common.dest);
     quiet_half_moves_ = 0;
 }
 
@@ -176,6 +305,56 @@ std::optional<Board> Board::init(std::string_view fen) {
                  *castling, en_passant_);
 }
 
+std::string Board::to_fen() const {
+    std::string fen;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty {};
+        for (int file = 0; file < 8; ++file) {
+            const char c { bitboard_.square_representation(static_cast<Square>(rank*8 + file)) };
+            if (c == ' ') {
+                ++empty;
+                continue;
+            }
+            if (empty) {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            fen += c;
+        }
+        if (empty) {
+            fen += static_cast<char>('0' + empty);
+        }
+        if (rank) {
+            fen += '/';
+        }
+    }
+
+    fen += turn_colour_ == WHITE ? " w " : " b ";
+
+    const std::size_t castling_start { fen.size() };
+    if (castling_.can_castle(WHITE, KING)) fen += 'K';
+    if (castling_.can_castle(WHITE, QUEEN)) fen += 'Q';
+    if (castling_.can_castle(BLACK, KING)) fen += 'k';
+    if (castling_.can_castle(BLACK, QUEEN)) fen += 'q';
+    if (fen.size() == castling_start) {
+        fen += '-';
+    }
+
+    fen += ' ';
+    if (en_passant_.has_value()) {
+        fen += static_cast<char>('a' + *en_passant_ % 8);
+        fen += static_cast<char>('1' + *en_passant_ / 8);
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ';
+    fen += std::to_string(quiet_half_moves_);
+    fen += ' ';
+    fen += std::to_string(fullmove_count_);
+    return fen;
+}
+
 static std::optional<Colour> turn_colour_from_fen(std::string_view fen) {
     if (fen == "w") {
         return WHITE;
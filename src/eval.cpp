@@ -0,0 +1,149 @@
+#include "eval.h"
+
+#include "board.h"
+#include "set_bit_iterator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace eval {
+
+namespace {
+
+using Table = std::array<int, NUM_SQUARES>;
+
+// From white's point of view and laid out as the board looks, rank 8 first, so a white piece
+// on square s reads entry s ^ 56 and a black piece entry s. These are the tables from the
+// "simplified evaluation function".
+constexpr Table PAWN_TABLE {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+constexpr Table KNIGHT_TABLE {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+};
+
+constexpr Table BISHOP_TABLE {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+};
+
+constexpr Table ROOK_TABLE {
+     0,  0,  0,  0,  0,  0,  0,  0,
+     5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+     0,  0,  0,  5,  5,  0,  0,  0,
+};
+
+constexpr Table QUEEN_TABLE {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20,
+};
+
+constexpr Table KING_MIDDLEGAME_TABLE {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20,
+};
+
+constexpr Table KING_ENDGAME_TABLE {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50,
+};
+
+constexpr std::array<const Table*, NUM_PIECES - 1> TABLES {
+    &PAWN_TABLE, &KNIGHT_TABLE, &BISHOP_TABLE, &ROOK_TABLE, &QUEEN_TABLE
+};
+
+// non-pawn material for both sides at the start, the king is fully in the middlegame table
+// until it starts coming off
+constexpr int MIDDLEGAME_MATERIAL {
+    2 * (2 * PIECE_VALUES[KNIGHT] + 2 * PIECE_VALUES[BISHOP] + 2 * PIECE_VALUES[ROOK] +
+         PIECE_VALUES[QUEEN])
+};
+
+constexpr std::size_t table_index(const Colour colour, const Square square) {
+    return colour == WHITE ? square ^ 56 : square;
+}
+
+} // namespace
+
+int evaluate(const Board &board) {
+    const Bitboard &bb { board.bitboard() };
+    // from white's point of view until the end
+    int score {};
+    int non_pawn_material {};
+    for (const auto colour : { WHITE, BLACK }) {
+        const int sign { colour == WHITE ? 1 : -1 };
+        for (const auto piece : NON_KING_PIECES) {
+            const std::uint64_t pieces { bb.colour_piece_mask(colour, piece) };
+            const int material { std::popcount(pieces) * PIECE_VALUES[piece] };
+            score += sign * material;
+            if (piece != PAWN) {
+                non_pawn_material += material;
+            }
+            for (const auto mask : SetBits(pieces)) {
+                score += sign * (*TABLES[piece])[table_index(colour, from_mask(mask))];
+            }
+        }
+    }
+
+    const int phase { std::min(non_pawn_material, MIDDLEGAME_MATERIAL) };
+    for (const auto colour : { WHITE, BLACK }) {
+        const std::uint64_t king { bb.colour_piece_mask(colour, KING) };
+        if (!king) {
+            continue;
+        }
+        const std::size_t index { table_index(colour, from_mask(king)) };
+        const int king_score {
+            (KING_MIDDLEGAME_TABLE[index] * phase +
+             KING_ENDGAME_TABLE[index] * (MIDDLEGAME_MATERIAL - phase)) / MIDDLEGAME_MATERIAL
+        };
+        score += colour == WHITE ? king_score : -king_score;
+    }
+
+    return board.turn_colour() == WHITE ? score : -score;
+}
+
+} // namespace eval
@@ -1,27 +1,205 @@
-#include "pawn.h"
-#include "king.h"
-#include "knight.h"
-#include "sliding_piece.h"
+#include "attack_table.h"
+#include "board.h"
+#include "move_gen.h"
+#include "move_parse.h"
+#include "search.h"
+#include "search_bench.h"
+#include "trace.h"
+#include "transposition_table.h"
+#include "uci.h"
+#include "utility.h"
 
-#include <iostream>
-#include "fenrir_assert.h"
+#include <algorithm>
+#include <boost/program_options.hpp>
 #include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+
+struct SearchArgs {
+    std::string fen;
+    std::vector<std::string> moves;
+    SearchLimits limits;
+    std::size_t hash_mb;
+    unsigned threads;
+    // empty to compare every mode with --bench
+    std::optional<ParallelMode> mode;
+    bool bench;
+    // with no limits it's a UCI engine reading commands from stdin
+    bool uci;
+    std::optional<std::string> trace;
+};
+
+std::optional<SearchArgs> parse_args(int argc, char **argv) {
+    po::options_description desc(
+        "With none of --depth, --nodes, --movetime or --bench, fenrir is a UCI engine and reads "
+        "commands from stdin, with --hash and --threads as the starting option values.\n\n"
+        "Allowed Options");
+    desc.add_options()
+        ("fen", po::value<std::string>()->default_value(
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"),
+            "FEN string of the position to search")
+        ("moves", po::value<std::vector<std::string>>()->multitoken(),
+            "space-separated list of moves to play from the FEN position first, e.g. e2e4 e7e5")
+        ("depth", po::value<int>()->default_value(0), "plies to search to, 0 for no limit")
+        ("nodes", po::value<std::uint64_t>()->default_value(0),
+            "nodes to stop searching after, 0 for no limit")
+        ("movetime", po::value<std::int64_t>()->default_value(0),
+            "milliseconds to stop searching after, 0 for no limit")
+        ("hash", po::value<std::size_t>()->default_value(16),
+            "megabytes for the transposition table")
+        ("threads", po::value<unsigned>()->default_value(1), "search threads")
+        ("parallel", po::value<std::string>(),
+            "how the threads share the work, \"lazy\" (Lazy SMP, the default) or \"abdada\"")
+        ("bench", "time searches of a fixed set of positions to --depth (8 by default) with "
+            "1, 2, 4, ... up to --threads threads, and print how the time to depth and NPS "
+            "scale. Both --parallel modes are compared unless one is given.")
+        ("trace", po::value<std::string>(),
+            "write a timeline of each search thread's iterations to this file, as Chrome "
+            "trace-event JSON. Not in UCI mode.");
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+
+        const SearchLimits limits {
+            std::max(0, vm["depth"].as<int>()),
+            vm["nodes"].as<std::uint64_t>(),
+            std::chrono::milliseconds(std::max<std::int64_t>(0, vm["movetime"].as<std::int64_t>()))
+        };
+        const bool bench { vm.count("bench") > 0 };
+        const bool uci { !bench && !limits.depth && !limits.nodes && !limits.time.count() };
+        if (uci && vm.count("trace")) {
+            std::cerr << "Error: --trace needs --depth, --nodes, --movetime or --bench\n";
+            return std::nullopt;
+        }
+        std::optional<ParallelMode> mode;
+        if (vm.count("parallel")) {
+            const std::string name { vm["parallel"].as<std::string>() };
+            mode = parse_parallel_mode(name);
+            if (!mode.has_value()) {
+                std::cerr << "Error: unknown parallel mode \"" << name << "\"\n";
+                return std::nullopt;
+            }
+        }
+
+        return SearchArgs {
+            vm["fen"].as<std::string>(),
+            vm.count("moves") ? vm["moves"].as<std::vector<std::string>>()
+                              : std::vector<std::string> {},
+            limits,
+            vm["hash"].as<std::size_t>(),
+            std::max(1u, vm["threads"].as<unsigned>()),
+            mode,
+            bench,
+            uci,
+            vm.count("trace") ? std::optional(vm["trace"].as<std::string>()) : std::nullopt
+        };
+    } catch (...) {
+        std::cerr << desc << "\n";
+        return std::nullopt;
+    }
+}
+
+static std::string pv_string(const std::vector<EncodedMove> &pv) {
+    std::string s;
+    for (const auto move : pv) {
+        if (!s.empty()) {
+            s += ' ';
+        }
+        s += move_to_string(move);
+    }
+    return s;
+}
+
+static int run(const SearchArgs &args) {
+    const AttackTable at {};
+    if (args.uci) {
+        Uci uci { at, std::cout, args.hash_mb, args.threads };
+        uci.run(std::cin);
+        return 0;
+    }
+    if (args.bench) {
+        const SearchBenchOptions options {
+            args.mode.has_value() ? std::vector { *args.mode }
+                                  : std::vector { ParallelMode::LAZY_SMP, ParallelMode::ABDADA },
+            doubling_thread_counts(args.threads),
+            args.limits.depth ? args.limits.depth : 8,
+            args.hash_mb
+        };
+        search_bench(std::cout, at, options);
+        return 0;
+    }
+
+    auto board { Board::init(args.fen) };
+    if (!board.has_value()) {
+        std::cerr << "Error: Invalid fen string\n";
+        return 1;
+    }
+
+    for (const auto &move_string : args.moves) {
+        for (const auto input_move : utility::split(move_string, ' ')) {
+            const auto parsed_move { parse_move_input(input_move, *board) };
+            if (!parsed_move.has_value()) {
+                std::cerr << "Error: move input \"" << input_move << "\" is invalid\n";
+                return 1;
+            }
+            if (!is_legal(*board, at, *parsed_move)) {
+                std::cerr << "Error: move \"" << input_move << "\" is not a legal move\n";
+                return 1;
+            }
+            board->make_move(*parsed_move);
+        }
+    }
+
+    TranspositionTable tt { args.hash_mb, std::thread::hardware_concurrency() };
+    Search search { at, tt, args.threads, args.mode.value_or(ParallelMode::LAZY_SMP) };
+    const auto result {
+        search.run(*board, args.limits, [](const IterationInfo &info) {
+            std::cout << "depth " << info.depth
+                      << " score " << score::to_string(info.score)
+                      << " nodes " << info.nodes
+                      << " nps " << info.nps()
+                      << " time " << info.elapsed.count()
+                      << " hashfull " << info.hashfull
+                      << " pv " << pv_string(info.pv) << "\n";
+        })
+    };
+
+    if (!result.best_move.has_value()) {
+        std::cout << "No legal moves, "
+                  << (result.score ? "checkmate" : "stalemate") << "\n";
+        return 0;
+    }
+    const SearchStats &stats { result.stats };
+    const double qnode_percent {
+        result.nodes ? 100.0 * static_cast<double>(stats.qnodes) / result.nodes : 0.0
+    };
+    std::cout << "qnodes " << stats.qnodes << " (" << std::fixed << std::setprecision(1)
+              << qnode_percent << "% of nodes) see pruned " << stats.see_pruned << "\n";
+    std::cout << "cutoffs " << stats.cutoffs << ", " << 100.0 * stats.first_move_cutoff_rate()
+              << "% on the first move, null move cutoffs " << stats.null_cutoffs << "\n";
+    std::cout << "late moves reduced " << stats.reductions << " (" << stats.lmr_re_searches
+              << " searched again) pruned " << stats.late_moves_pruned << "\n";
+    std::cout << "pvs re-searches " << stats.pvs_re_searches << ", aspiration fail lows "
+              << stats.aspiration_fail_lows << " fail highs " << stats.aspiration_fail_highs
+              << "\n";
+    std::cout << "bestmove " << move_to_string(*result.best_move) << "\n";
+    return 0;
+}
 
-int main() {
-    const auto t0 { std::chrono::steady_clock::now() };
-    const SlidingPieceAttacks attacks;
-    const auto t1 { std::chrono::steady_clock::now() };
-    const auto taken { std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count() };
-    std::cout << "Took " << taken/1000 << "." << taken%1000 << " seconds\n";
-
-    const auto t2 { std::chrono::steady_clock::now() };
-    constexpr piece::PawnAttackTable pawns;
-    constexpr auto knights { piece::generate_knight_att_squares() };
-    constexpr auto kings { piece::generate_king_att_squares() } ;
-    (void)knights;
-    (void)kings;
-    (void)pawns;
-    const auto t3 { std::chrono::steady_clock::now() };
-    const auto taken2 { std::chrono::duration_cast<std::chrono::milliseconds>(t2-t3).count() };
-    std::cout << "Took " << taken2 / 1000 << "." << taken2 % 1000 << " seconds\n";
-}
\ No newline at end of file
+int main(int argc, char **argv) {
+    const auto args { parse_args(argc, argv) };
+    if (!args.has_value()) {
+        return 1;
+    }
+    trace::Output trace_output { args->trace };
+    return trace_output.finish(run(*args));
+}
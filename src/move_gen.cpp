@@ -1,448 +1,285 @@
 #include "attack_table.h"
 #include "bitboard.h"
 #include "board.h"
+#include "colour_traits.h"
 #include "masks.h"
 #include "move_gen.h"
 #include "set_bit_iterator.h"
+#include "zone_profiler.h"
 
 #include <algorithm>
 #include <bit>
 #include "fenrir_assert.h"
-#include <cmath>
 #include <exception>
 #include <numeric>
 #include <utility>
 
-static bool is_promotion(const std::uint64_t targets) {
-    static constexpr std::uint64_t PROMOTION_RANKS {
-        (1ul << A1) | (1ul << B1) | (1ul << C1) | (1ul << D1) |
-        (1ul << E1) | (1ul << F1) | (1ul << G1) | (1ul << H1) |
-        (1ul << A8) | (1ul << B8) | (1ul << C8) | (1ul << D8) |
-        (1ul << E8) | (1ul << F8) | (1ul << G8) | (1ul << H8)
-    };
-
-    return (targets & PROMOTION_RANKS) > 0;
-}
-
-MoveGen::MoveGen(std::vector<EncodedMove> &moves, 
-                 Board &board,
+MoveGen::MoveGen(std::vector<EncodedMove> &moves,
+                 const Board &board,
                  const AttackTable &at) :
-        MoveGen(moves, board.bitboard(), at, board.turn_colour(), 
-                board.castling_rights(), board.en_passant(), 
-                king_danger_squares(board.bitboard(), at, board.turn_colour()))
-{}
-
-MoveGen::MoveGen(std::vector<EncodedMove> &moves, 
-                 Bitboard &bb, 
-                 const AttackTable &at,
-                 const Colour friendly_colour, 
-                 CastlingRights castling, 
-                 std::optional<Square> en_passant,
-                 const KingInfo &king_info) :
         moves(moves),
-        bb(bb),
-        at(at),
-        friendly_colour(friendly_colour),
-        castling_rights(castling),
-        en_passant(en_passant),
-        pinned(pinned_pieces(bb, at, friendly_colour)),
-        danger_squares(king_info.king_danger_squares),
-        checking_pieces(king_info.king_checking_pieces),
-        check_intervention_squares(king_info.check_intervention_squares)
+        board(board),
+        at(at)
 {}
 
 void MoveGen::gen() && {
     moves.clear();
-    // If in check by more than 1 piece, the only way to get out of it is to move
-    // the king
-    if (std::popcount(checking_pieces) > 1) {
-        return king_moves();
-
-    } else if (std::popcount(checking_pieces) == 1) {
-        return escape_single_check();
-    } 
-
-    // Not in check
+    for_each(board, at, [this](const EncodedMove move) {
+        moves.push_back(move);
+    });
+}
 
-    castling(KING);
-    castling(QUEEN);
+void MoveGen::gen_pseudo_legal() && {
+    moves.clear();
+    for_each<GenMode::PSEUDO_LEGAL>(board, at, [this](const EncodedMove move) {
+        moves.push_back(move);
+    });
+}
 
-    generate_pawn_moves();
+void MoveGen::gen_captures() && {
+    moves.clear();
+    for_each<GenMode::CAPTURES>(board, at, [this](const EncodedMove move) {
+        moves.push_back(move);
+    });
+}
 
-    for (const auto piece_type : NORMAL_PIECES) {
-        captures_for_piece_type(piece_type);
-    }
+bool has_legal_move(const Board &board, const AttackTable &at) {
+    return first_legal_move(board, at).has_value();
+}
 
+std::optional<EncodedMove> first_legal_move(const Board &board, const AttackTable &at) {
+    std::optional<EncodedMove> rv;
+    MoveGen::for_each(board, at, [&rv](const EncodedMove move) {
+        rv = move;
+        return false;
+    });
+    return rv;
+}
 
-    for (const auto piece_type : NORMAL_PIECES) {
-        quiet_moves_for_piece_type(piece_type);
+MateStatus mate_status(const Board &board, const AttackTable &at) {
+    if (has_legal_move(board, at)) {
+        return MateStatus::NONE;
     }
-
-    king_moves();
+    return king_in_check(board.bitboard(), at, board.turn_colour()) ? MateStatus::CHECKMATE
+                                                                    : MateStatus::STALEMATE;
 }
 
-static bool in_line_with_king(const std::uint64_t source, const std::uint64_t dest,
-                              const std::uint64_t king_pos) {
-    return direction::SOURCE_DEST_MASKS[from_mask(king_pos)][from_mask(source)] & dest;
+template <Colour Us>
+std::uint64_t enemy_attackers(const Bitboard &bb, const AttackTable &at, const Square square,
+                              const std::uint64_t occupied) {
+    constexpr Colour Them { opposite(Us) };
+    const std::uint64_t queens { bb.colour_piece_mask(Them, QUEEN) };
+    return (ColourTraits<Us>::pawn_attacks(from_square(square)) &
+            bb.colour_piece_mask(Them, PAWN))
+         | (at.attacks(square, KNIGHT, Us, occupied) & bb.colour_piece_mask(Them, KNIGHT))
+         | (at.attacks(square, BISHOP, Us, occupied) &
+            (bb.colour_piece_mask(Them, BISHOP) | queens))
+         | (at.attacks(square, ROOK, Us, occupied) & (bb.colour_piece_mask(Them, ROOK) | queens))
+         | (at.attacks(square, KING, Us, occupied) & bb.colour_piece_mask(Them, KING));
 }
 
-void MoveGen::push_if_legal(
-    const MoveType type, const std::uint64_t source, const std::uint64_t dest,
-    const Piece piece, const Piece captured_piece, const Piece promoted_piece
-) {
-    if (type == MoveType::EN_PASSANT) {
-        const EncodedMove encoded_move( 
-            type,
-            from_mask(source),
-            from_mask(dest),
-            piece,
-            friendly_colour,
-            captured_piece,
-            promoted_piece
-        );
-        const DecodedMove move { decode(encoded_move) };
-        bb.make_move(move);
-        const bool legal { !king_in_check(bb, at, friendly_colour) };
-        bb.unmake_move(move);
-        if (legal) {
-            moves.push_back(encoded_move);
-        }
-        return;
+template <Colour Us>
+static bool is_pseudo_legal(const Board &board, const AttackTable &at, const EncodedMove move) {
+    using Traits = ColourTraits<Us>;
+    constexpr Colour Them { Traits::them };
+
+    if (move.piece >= NUM_PIECES) {
+        return false;
     }
+    const Bitboard &bb { board.bitboard() };
+    const Piece piece { static_cast<Piece>(move.piece) };
+    const Square source { static_cast<Square>(move.source_square) };
+    const Square dest { static_cast<Square>(move.dest_square) };
+    const std::uint64_t source_mask { from_square(source) };
+    const std::uint64_t dest_mask { from_square(dest) };
+    const std::uint64_t occupied { bb.entire_mask() };
 
-    if (!(source & pinned) || 
-        in_line_with_king(source, dest, bb.colour_piece_mask(friendly_colour, KING))
-    ) {
-        moves.emplace_back(type,
-                           from_mask(source),
-                           from_mask(dest),
-                           piece,
-                           friendly_colour,
-                           captured_piece,
-                           promoted_piece);
+    if (!(bb.colour_piece_mask(Us, piece) & source_mask)) {
+        return false;
     }
-}
 
-/* if there's only a single checker, the options are: 
-* 1. Capture the checking piece
-* 2. A non-king piece blocking the check (if the checker is a sliding piece)
-* 3. Move the king */
-void MoveGen::escape_single_check() {
-    // captures of checking piece
-    for (const auto piece_type : NON_KING_PIECES) {
-        const auto all_src_pieces { bb.colour_piece_mask(friendly_colour, piece_type) };
-        for (const auto single_src_piece : SetBits(all_src_pieces)) {
-            const std::uint64_t ep_mask { 
-                (en_passant && piece_type == PAWN ? from_square(*en_passant) : 0ul) 
-            };
-            const std::uint64_t enemy_mask {
-                bb.colour_mask(opposite(friendly_colour)) | ep_mask
-            };
-            const auto captures {
-                at.captures(from_mask(single_src_piece), piece_type, friendly_colour,
-                            bb.entire_mask(), enemy_mask)
-            };
-            const auto captures_of_checking_piece {
-                captures & check_intervention_squares 
-            };
-            if (captures_of_checking_piece) {
-                const auto checking_piece { bb.square_occupant(from_mask(checking_pieces)) };
-                BOOST_ASSERT(checking_piece.has_value());
-                BOOST_ASSERT(checking_piece->first == opposite(friendly_colour));
-                if (piece_type == PAWN) {
-                    single_pawn_captures(single_src_piece, captures_of_checking_piece, 
-                                         checking_piece->second, opposite(friendly_colour));
-                } else {
-                    push_if_legal(MoveType::CAPTURE, single_src_piece, checking_pieces, piece_type,
-                                checking_piece->second, NUM_PIECES);
-                }
+    const bool no_capture { move.captured_piece == NUM_PIECES };
+    const bool no_promotion { move.promoted_piece == NUM_PIECES };
+    const bool valid_promotion { move.promoted_piece >= KNIGHT && move.promoted_piece <= QUEEN };
+    // the captured piece has to be the one actually sitting on the destination square
+    const bool captures_occupant {
+        move.captured_piece < KING &&
+        (bb.colour_piece_mask(Them, static_cast<Piece>(move.captured_piece)) & dest_mask)
+    };
+
+    switch (static_cast<MoveType>(move.move_type)) {
+        case MoveType::QUIET:
+            if (!no_capture || !no_promotion || (occupied & dest_mask)) {
+                return false;
             }
-            // push_if_legal will check if the en-passant is legal
-            if (captures & ep_mask) {
-                push_if_legal(MoveType::EN_PASSANT, single_src_piece, ep_mask, PAWN,
-                              PAWN, NUM_PIECES);
+            if (piece == PAWN) {
+                return dest_mask == (Traits::push(source_mask) & ~Traits::promotion_rank);
             }
-        }
-    }
-
-    // blocks
-    for (const auto piece_type : NON_KING_PIECES) {
-        const auto all_src_pieces { bb.colour_piece_mask(friendly_colour, piece_type) };
-        for (const auto single_src_piece : SetBits(all_src_pieces)) {
-            const auto blocks {
-                at.moves_(from_mask(single_src_piece), piece_type, friendly_colour, bb.entire_mask())
-                & check_intervention_squares
-            };
-            if (piece_type == PAWN) {
-                single_pawn_quiet_moves(single_src_piece, blocks);
-            } else {
-                for (const auto dest : SetBits(blocks)) {
-                    push_if_legal(MoveType::QUIET, single_src_piece, dest, piece_type, 
-                                NUM_PIECES, NUM_PIECES);
-                }
+            return at.moves_(source, piece, Us, occupied) & dest_mask;
+        case MoveType::CAPTURE:
+            if (!no_promotion || !captures_occupant) {
+                return false;
             }
+            if (piece == PAWN && (dest_mask & Traits::promotion_rank)) {
+                return false;
+            }
+            return at.attacks(source, piece, Us, occupied) & dest_mask;
+        case MoveType::DOUBLE_PAWN_PUSH: {
+            if (piece != PAWN || !no_capture || !no_promotion) {
+                return false;
+            }
+            const std::uint64_t single_push { Traits::push(source_mask) & ~occupied };
+            return dest_mask == (Traits::push(single_push & Traits::double_push_rank) & ~occupied);
         }
+        case MoveType::CASTLE_KINGSIDE:
+            return piece == KING && no_capture && no_promotion &&
+                   source == Traits::king_start && dest == Traits::kingside_dest &&
+                   board.castling_rights().can_castle(Us, KING) &&
+                   !(occupied & Traits::kingside_clear);
+        case MoveType::CASTLE_QUEENSIDE:
+            return piece == KING && no_capture && no_promotion &&
+                   source == Traits::king_start && dest == Traits::queenside_dest &&
+                   board.castling_rights().can_castle(Us, QUEEN) &&
+                   !(occupied & Traits::queenside_clear);
+        case MoveType::EN_PASSANT:
+            return piece == PAWN && move.captured_piece == PAWN && no_promotion &&
+                   board.en_passant() == dest && (dest_mask & Traits::en_passant_rank) &&
+                   (at.attacks(source, PAWN, Us, occupied) & dest_mask);
+        case MoveType::MOVE_PROMOTION:
+            return piece == PAWN && no_capture && valid_promotion && !(occupied & dest_mask) &&
+                   dest_mask == (Traits::push(source_mask) & Traits::promotion_rank);
+        case MoveType::CAPTURE_PROMOTION:
+            return piece == PAWN && valid_promotion && captures_occupant &&
+                   (dest_mask & Traits::promotion_rank) &&
+                   (at.attacks(source, PAWN, Us, occupied) & dest_mask);
+        default:
+            return false;
     }
-
-    king_moves();
-}
-
-void MoveGen::king_moves() {
-    const Square king_sq { from_mask(bb.colour_piece_mask(friendly_colour, KING)) };
-    const std::uint64_t blockers { bb.entire_mask() };
-    std::uint64_t king_attacks { 
-        at.attacks(king_sq, KING, friendly_colour, blockers) 
-    };
-    king_attacks &= ~bb.colour_mask(friendly_colour);
-    king_attacks &= ~danger_squares;
-
-    if (king_attacks == 0) {
-        return;
-    }
-
-    EncodedMove template_move(
-        MoveType::CAPTURE,
-        king_sq,
-        NUM_SQUARES, // dest square, to be filled in
-        KING,
-        friendly_colour,
-        NUM_PIECES, // captured piece, to be filled in
-        NUM_PIECES
-    );
-
-    for (const auto capturable : CAPTURABLE_PIECES) {
-        template_move.captured_piece = static_cast<std::uint32_t>(capturable);
-        const std::uint64_t captures_of_piece {
-            bb.colour_piece_mask(opposite(friendly_colour), capturable) & king_attacks
-        };
-        king_attacks ^= captures_of_piece;
-        auto set_bits { SetBits(captures_of_piece) };
-        std::transform(set_bits.begin(), set_bits.end(), std::back_inserter(moves), 
-                       [=](const auto capture_of_piece) mutable {
-            template_move.dest_square = static_cast<std::uint32_t>(from_mask(capture_of_piece));
-            return template_move;
-        });
-    }
-
-    // all remaining moves are quiet moves
-    template_move.move_type = static_cast<std::uint32_t>(MoveType::QUIET);
-    template_move.captured_piece = static_cast<std::uint32_t>(NUM_PIECES);
-    auto set_bits { SetBits(king_attacks) };
-    std::transform(set_bits.begin(), set_bits.end(), std::back_inserter(moves),
-                   [=](const auto quiet_move) mutable {
-        template_move.dest_square = static_cast<std::uint32_t>(from_mask(quiet_move));
-        return template_move;
-    });
 }
 
-// We invalidate castling if the king/rook ever moves, so all we need to check is
-// if the path is clear and whether the intermediate squares are under attack.
-// This means things fall over if the castling rights we pass in are incorrect, we
-// assume if castling is allowed the king/rook are on their original squares.
-void MoveGen::castling(const Piece side) {
-    BOOST_ASSERT(side == KING || side == QUEEN);
-
-    if (!castling_rights.can_castle(friendly_colour, side)) {
-        return;
-    }
+// Assumes the move is pseudo-legal. Rather than make the move we work out the occupancy it
+// leaves behind and check nothing attacks the king through it. For a non-king move that
+// covers both pins and resolving a check, as the only attackers that can remain are ones the
+// move neither captured nor blocked.
+template <Colour Us>
+static bool king_safe_after(const Board &board, const AttackTable &at, const EncodedMove move) {
+    using Traits = ColourTraits<Us>;
+    const Bitboard &bb { board.bitboard() };
+    const std::uint64_t king { bb.colour_piece_mask(Us, KING) };
+    const std::uint64_t source_mask { from_square(static_cast<Square>(move.source_square)) };
+    const Square dest { static_cast<Square>(move.dest_square) };
+    const std::uint64_t dest_mask { from_square(dest) };
+    const std::uint64_t occupied { bb.entire_mask() };
 
-    const std::uint64_t required_clear_squares { [=, this] {
-        if (friendly_colour == WHITE) {
-            return side == KING ? from_square(F1) | from_square(G1)
-                                : from_square(B1) | from_square(C1) | from_square(D1);
-        } else {
-            return side == KING ? from_square(F8) | from_square(G8)
-                                : from_square(B8) | from_square(C8) | from_square(D8);
-        }
-    }() };
-
-    const std::uint64_t required_no_incoming_attack_squares { [=, this] {
-        if (friendly_colour == WHITE) {
-            return side == KING ? from_square(F1) | from_square(G1)
-                                : from_square(C1) | from_square(D1);
-        } else {
-            return side == KING ? from_square(F8) | from_square(G8)
-                                : from_square(C8) | from_square(D8);
-        }
-    }() };
-
-    const Square king_sq { friendly_colour == WHITE ? E1 : E8 };
-    const Square dest_sq { [=, this] {
-        if (friendly_colour == WHITE) {
-            return side == KING ? G1 : C1;
-        } else {
-            return side == KING ? G8 : C8;
+    switch (static_cast<MoveType>(move.move_type)) {
+        case MoveType::CASTLE_KINGSIDE:
+        case MoveType::CASTLE_QUEENSIDE: {
+            // can't castle out of, through, or into check
+            const std::uint64_t path {
+                king | (static_cast<MoveType>(move.move_type) == MoveType::CASTLE_KINGSIDE
+                            ? Traits::kingside_safe : Traits::queenside_safe)
+            };
+            for (const auto square : SetBits(path)) {
+                if (enemy_attackers<Us>(bb, at, from_mask(square), occupied)) {
+                    return false;
+                }
+            }
+            return true;
         }
-    }() };
-#ifndef NDEBUG
-    const Square rook_sq { [=, this] {
-        if (friendly_colour == WHITE) {
-            return side == KING ? H1 : A1;
-        } else {
-            return side == KING ? H8 : A8;
+        case MoveType::EN_PASSANT: {
+            const std::uint64_t captured_pawn { Traits::push_back(dest_mask) };
+            const std::uint64_t after { (occupied ^ source_mask ^ captured_pawn) | dest_mask };
+            return !(enemy_attackers<Us>(bb, at, from_mask(king), after) & ~captured_pawn);
         }
-    }() };
-#endif
-
-    // check the king hasn't moved
-    BOOST_ASSERT(from_mask(bb.colour_piece_mask(friendly_colour, KING)) == king_sq);
-    // check the rook hasn't moved
-    BOOST_ASSERT(bb.colour_piece_mask(friendly_colour, ROOK) & from_square(rook_sq));
-
-    //     are the intermediate squares blocked? 
-    if ( !(required_clear_squares & bb.entire_mask() || 
-           // are the intermediate squares under attack?
-           required_no_incoming_attack_squares & danger_squares) ) {
-        const auto type { side == KING ? MoveType::CASTLE_KINGSIDE : MoveType::CASTLE_QUEENSIDE };
-        moves.emplace_back(type,
-                           king_sq,
-                           dest_sq,
-                           KING,
-                           friendly_colour,
-                           NUM_PIECES,
-                           NUM_PIECES);
+        default:
+            break;
     }
-}
 
-void MoveGen::quiet_moves_for_piece_type(const Piece piece_type) {
-    const std::uint64_t all_pieces { bb.entire_mask() };
-    const std::uint64_t all_src_pieces { bb.colour_piece_mask(friendly_colour, piece_type) };
-    for (const std::uint64_t single_src_piece : SetBits(all_src_pieces)) {
-        const std::uint64_t quiet_moves { 
-            at.moves_(from_mask(single_src_piece), piece_type, friendly_colour, all_pieces)
-        };
-        for (const auto single_move : SetBits(quiet_moves)) {
-            push_if_legal(MoveType::QUIET, single_src_piece, single_move, piece_type,
-                          NUM_PIECES, NUM_PIECES);
-        }
+    if (move.piece == KING) {
+        // remove the king so it can't shield the destination from a slider behind it
+        return !enemy_attackers<Us>(bb, at, dest, occupied ^ king);
     }
-}
 
-void MoveGen::captures_for_piece_type(const Piece piece_type) {
-    const std::uint64_t all_src_pieces { bb.colour_piece_mask(friendly_colour, piece_type) };
-    for (const std::uint64_t single_src_piece : SetBits(all_src_pieces)) {
-        captures_for_single_piece(piece_type, single_src_piece);
-    }
+    const std::uint64_t after { (occupied ^ source_mask) | dest_mask };
+    return !(enemy_attackers<Us>(bb, at, from_mask(king), after) & ~dest_mask);
 }
 
-void MoveGen::captures_for_single_piece(
-    const Piece piece_type, const std::uint64_t single_src_piece
-) {
-    const Colour enemy_colour { opposite(friendly_colour) }; 
-    const std::uint64_t enemy_pieces_mask { bb.colour_mask(enemy_colour) };
-    const std::uint64_t all_pieces { bb.entire_mask() };
-
-    const std::uint64_t captures { 
-        at.captures(from_mask(single_src_piece), piece_type, friendly_colour, 
-                                all_pieces, enemy_pieces_mask) 
-    };
-
-    if (captures == 0) {
-        return;
-    }
-
-    for (const Piece capturable_piece : CAPTURABLE_PIECES) {
-        const std::uint64_t captures_of_piece {
-            captures & bb.colour_piece_mask(enemy_colour, capturable_piece)
-        };
-        for (const auto single_capture : SetBits(captures_of_piece)) {
-            push_if_legal(MoveType::CAPTURE, single_src_piece, single_capture,
-                          piece_type, capturable_piece, NUM_PIECES);
-        }
+bool is_pseudo_legal(const Board &board, const AttackTable &at, const EncodedMove move) {
+    if (move.colour != board.turn_colour()) {
+        return false;
     }
+    return board.turn_colour() == WHITE ? is_pseudo_legal<WHITE>(board, at, move)
+                                        : is_pseudo_legal<BLACK>(board, at, move);
 }
 
-void MoveGen::single_pawn_quiet_moves(
-    const std::uint64_t single_pawn, std::uint64_t quiet_moves
-) {
-    BOOST_ASSERT(std::popcount(quiet_moves) <= 2);
-    for (const auto single_move : SetBits(quiet_moves)) {
-        if (is_promotion(single_move)) {
-            for (const auto promotion_piece : PROMOTION_PIECES) {
-                push_if_legal(MoveType::MOVE_PROMOTION, single_pawn, single_move, PAWN,
-                              NUM_PIECES, promotion_piece);
-            }
-        } else {
-            const int diff {
-                std::abs(std::countr_zero(single_move) - std::countr_zero(single_pawn))
-            };
-            BOOST_ASSERT(diff == 8 || diff == 16);
-            const auto type { diff == 16 ? MoveType::DOUBLE_PAWN_PUSH : MoveType::QUIET };
-            push_if_legal(type, single_pawn, single_move, PAWN, NUM_PIECES, NUM_PIECES);
-        }
+bool is_legal(const Board &board, const AttackTable &at, const EncodedMove move) {
+    if (!is_pseudo_legal(board, at, move)) {
+        return false;
     }
+    return board.turn_colour() == WHITE ? king_safe_after<WHITE>(board, at, move)
+                                        : king_safe_after<BLACK>(board, at, move);
 }
 
-void MoveGen::single_pawn_captures(const std::uint64_t single_pawn, const std::uint64_t captures,
-                                   const Piece capturable, const Colour enemy_colour) {
-    const auto captures_of_piece { captures & bb.colour_piece_mask(
-        enemy_colour, capturable
-    ) };
-    for (const auto single_capture : SetBits(captures_of_piece)) {
-        if (is_promotion(captures)) {
-            for (const auto promotion_piece : PROMOTION_PIECES) {
-                push_if_legal(MoveType::CAPTURE_PROMOTION, single_pawn, single_capture,
-                              PAWN, capturable, promotion_piece);
-            }
-        } else {
-            push_if_legal(MoveType::CAPTURE, single_pawn, single_capture, PAWN,
-                          capturable, NUM_PIECES);
-        } 
+template <Colour Us>
+static bool legal_after_pseudo(const Board &board, const AttackTable &at, const EncodedMove move) {
+    constexpr Colour Them { opposite(Us) };
+    switch (static_cast<MoveType>(move.move_type)) {
+        // castling is only generated when it's legal
+        case MoveType::CASTLE_KINGSIDE:
+        case MoveType::CASTLE_QUEENSIDE:
+            return true;
+        case MoveType::EN_PASSANT:
+            return king_safe_after<Us>(board, at, move);
+        default:
+            break;
     }
-}
-
-void MoveGen::single_pawn_moves(const std::uint64_t single_pawn) {
-    const Colour enemy_colour { opposite(friendly_colour) };
-    const std::uint64_t ep_mask { en_passant ? from_square(*en_passant) : 0ul };
-    const std::uint64_t enemy_pieces_mask { bb.colour_mask(enemy_colour) | ep_mask };
-    const std::uint64_t captures { 
-        at.captures(from_mask(single_pawn), PAWN, friendly_colour, 0ul, enemy_pieces_mask) };
-    BOOST_ASSERT(std::popcount(captures) <= 2);
-
-    if (captures > 0) {
-        for (const auto capturable : CAPTURABLE_PIECES) {
-            single_pawn_captures(single_pawn, captures, capturable, enemy_colour);
-        } 
+    if (move.piece == KING) {
+        return king_safe_after<Us>(board, at, move);
     }
 
-    const std::uint64_t ep_captures { ep_mask & captures };
-    if (ep_captures > 0) {
-        BOOST_ASSERT(std::popcount(ep_captures) == 1);
-        push_if_legal(MoveType::EN_PASSANT, single_pawn, ep_mask, PAWN, PAWN, NUM_PIECES);
+    // Any check has already been dealt with by generation so the only way left to expose the
+    // king is moving a pinned piece off its line, which needs the piece to be in line with the
+    // king in the first place
+    const Bitboard &bb { board.bitboard() };
+    const Square king_sq { from_mask(bb.colour_piece_mask(Us, KING)) };
+    const Square source { static_cast<Square>(move.source_square) };
+    if (!direction::SOURCE_DEST_MASKS[king_sq][source]) {
+        return true;
     }
 
-    const std::uint64_t all_pieces { bb.entire_mask() };
-    const std::uint64_t quiet_moves {
-        at.moves_(from_mask(single_pawn), PAWN, friendly_colour, all_pieces)
+    const std::uint64_t dest_mask { from_square(static_cast<Square>(move.dest_square)) };
+    const std::uint64_t after { (bb.entire_mask() ^ from_square(source)) | dest_mask };
+    const std::uint64_t queens { bb.colour_piece_mask(Them, QUEEN) };
+    const std::uint64_t sliders {
+        (at.attacks(king_sq, BISHOP, Us, after) & (bb.colour_piece_mask(Them, BISHOP) | queens)) |
+        (at.attacks(king_sq, ROOK, Us, after) & (bb.colour_piece_mask(Them, ROOK) | queens))
     };
-
-    if (quiet_moves > 0) {
-        single_pawn_quiet_moves(single_pawn, quiet_moves);
-    }
+    return !(sliders & ~dest_mask);
 }
 
-void MoveGen::generate_pawn_moves() {
-    const std::uint64_t all_pawns { bb.colour_piece_mask(friendly_colour, PAWN) };
-    for (const auto single_pawn : SetBits(all_pawns)) {
-        single_pawn_moves(single_pawn);
-    }
+bool legal_after_pseudo(const Board &board, const AttackTable &at, const EncodedMove move) {
+    return board.turn_colour() == WHITE ? legal_after_pseudo<WHITE>(board, at, move)
+                                        : legal_after_pseudo<BLACK>(board, at, move);
 }
 
-KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at, const Colour colour) {
+template <Colour Us>
+KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at) {
+    FENRIR_ZONE(KING_DANGER);
+    constexpr Colour Them { opposite(Us) };
     std::uint64_t king_danger_squares {};
     std::uint64_t king_checking_pieces {};
     std::uint64_t check_intervention_squares {};
 
-    const auto king_pos { bb.colour_piece_mask(colour, KING) };
+    const auto king_pos { bb.colour_piece_mask(Us, KING) };
     // remove the king as a king will still be in danger if moving backwards along the
     // ray of a sliding piece
     const std::uint64_t blockers { bb.entire_mask() ^ king_pos };
 
     for (const Piece piece_type : ALL_PIECES) {
-        const std::uint64_t pieces { bb.colour_piece_mask(opposite(colour), piece_type) };
+        const std::uint64_t pieces { bb.colour_piece_mask(Them, piece_type) };
         for (const auto piece : SetBits(pieces)) {
             const auto attacks { 
-                at.attacks(from_mask(piece), piece_type, opposite(colour), blockers) 
+                at.attacks(from_mask(piece), piece_type, Them, blockers) 
             };
             king_danger_squares |= attacks;
             if (!(attacks & king_pos)) { 
@@ -500,39 +337,57 @@ KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at, const Co
     };
 }
 
-bool king_in_check(const Bitboard &bb, const AttackTable &at, const Colour colour) {
-    const Square king_sq { from_mask(bb.colour_piece_mask(colour, KING)) }; 
-    const Colour enemy_colour { opposite(colour) };
-    const std::uint64_t occupied { bb.entire_mask() };
-    const std::uint64_t enemies { bb.colour_mask(enemy_colour) };
-    // using CAPTURABLE_PIECES cos it's in descending order of value, and the most
-    // valuable pieces are probs more likely to check the king? 
-    return std::any_of(CAPTURABLE_PIECES.begin(), CAPTURABLE_PIECES.end(), 
-                       [=, &at, &bb](const auto piece_type) {
-        const std::uint64_t piece_mask { bb.colour_piece_mask(enemy_colour, piece_type) };
-        return (piece_mask & at.captures(king_sq, piece_type, colour, occupied, enemies));
-    });
+template <Colour Us>
+KingInfo king_checkers(const Bitboard &bb, const AttackTable &at) {
+    FENRIR_ZONE(KING_DANGER);
+    const std::uint64_t king_pos { bb.colour_piece_mask(Us, KING) };
+    const Square king_sq { from_mask(king_pos) };
+    const std::uint64_t checkers { enemy_attackers<Us>(bb, at, king_sq, bb.entire_mask()) };
+    std::uint64_t check_intervention_squares { checkers };
+    // same as in king_danger_squares, only sliding pieces have squares in-between
+    for (const auto checker : SetBits(checkers)) {
+        check_intervention_squares |= (
+            direction::SOURCE_DEST_MASKS[king_sq][from_mask(checker)] &
+            direction::SOURCE_DEST_MASKS[from_mask(checker)][king_sq]
+        );
+    }
+    return KingInfo {
+        0ul,
+        checkers,
+        check_intervention_squares
+    };
 }
 
-std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at, const Colour colour) {
-    const std::uint64_t king_pos { bb.colour_piece_mask(colour, KING) };
+template <Colour Us>
+bool king_in_check(const Bitboard &bb, const AttackTable &at) {
+    const Square king_sq { from_mask(bb.colour_piece_mask(Us, KING)) };
+    // the pawn attack table has nothing for the first and last ranks, so a king on its back
+    // rank has to get its pawn checkers from the pawn attacks instead
+    return enemy_attackers<Us>(bb, at, king_sq, bb.entire_mask()) != 0;
+}
+
+template <Colour Us>
+std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at) {
+    FENRIR_ZONE(PINS);
+    constexpr Colour Them { opposite(Us) };
+    const std::uint64_t king_pos { bb.colour_piece_mask(Us, KING) };
     const Square king_sq { from_mask(king_pos) };
-    const std::uint64_t enemy_queens { bb.colour_piece_mask(opposite(colour), QUEEN) };
+    const std::uint64_t enemy_queens { bb.colour_piece_mask(Them, QUEEN) };
     // pretend the queen is a rook/bishop for the sake of pin calculations
     const std::uint64_t enemy_rooks { 
-        bb.colour_piece_mask(opposite(colour), ROOK) | enemy_queens
+        bb.colour_piece_mask(Them, ROOK) | enemy_queens
     };
     const std::uint64_t enemy_bishops { 
-        bb.colour_piece_mask(opposite(colour), BISHOP) | enemy_queens
+        bb.colour_piece_mask(Them, BISHOP) | enemy_queens
     };
 
     // place a rook/bishop in the friendly king position and see which friendly pieces it would
     // attack, which gives us candidates for pinned pieces
     const std::uint64_t rook_pin_candidates {
-        at.captures(king_sq, ROOK, opposite(colour), bb.entire_mask(), bb.colour_mask(colour))
+        at.captures(king_sq, ROOK, Them, bb.entire_mask(), bb.colour_mask(Us))
     };
     const std::uint64_t bishop_pin_candidates {
-        at.captures(king_sq, BISHOP, opposite(colour), bb.entire_mask(), bb.colour_mask(colour))
+        at.captures(king_sq, BISHOP, Them, bb.entire_mask(), bb.colour_mask(Us))
     };
 
     std::uint64_t rv {};
@@ -547,9 +402,9 @@ std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at, const Col
             rv |= (
                 at.captures(from_mask(rook_in_line), 
                             ROOK, 
-                            opposite(colour), 
+                            Them, 
                             bb.entire_mask(), 
-                            bb.colour_mask(colour)) & rook_pin_candidate
+                            bb.colour_mask(Us)) & rook_pin_candidate
             );
         };
     }
@@ -563,12 +418,38 @@ std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at, const Col
             rv |= (
                 at.captures(from_mask(bishop_in_line), 
                             BISHOP, 
-                            opposite(colour), 
+                            Them, 
                             bb.entire_mask(), 
-                            bb.colour_mask(colour)) & bishop_pin_candidate
+                            bb.colour_mask(Us)) & bishop_pin_candidate
             );
         };
     }
 
     return rv;
 }
+
+template std::uint64_t pinned_pieces<WHITE>(const Bitboard &bb, const AttackTable &at);
+template std::uint64_t pinned_pieces<BLACK>(const Bitboard &bb, const AttackTable &at);
+template KingInfo king_danger_squares<WHITE>(const Bitboard &bb, const AttackTable &at);
+template KingInfo king_danger_squares<BLACK>(const Bitboard &bb, const AttackTable &at);
+template bool king_in_check<WHITE>(const Bitboard &bb, const AttackTable &at);
+template bool king_in_check<BLACK>(const Bitboard &bb, const AttackTable &at);
+template KingInfo king_checkers<WHITE>(const Bitboard &bb, const AttackTable &at);
+template KingInfo king_checkers<BLACK>(const Bitboard &bb, const AttackTable &at);
+template std::uint64_t enemy_attackers<WHITE>(const Bitboard &bb, const AttackTable &at,
+                                              const Square square, const std::uint64_t occupied);
+template std::uint64_t enemy_attackers<BLACK>(const Bitboard &bb, const AttackTable &at,
+                                              const Square square, const std::uint64_t occupied);
+
+std::uint64_t pinned_pieces(const Bitboard &bb, const AttackTable &at, const Colour colour) {
+    return colour == WHITE ? pinned_pieces<WHITE>(bb, at) : pinned_pieces<BLACK>(bb, at);
+}
+
+KingInfo king_danger_squares(const Bitboard &bb, const AttackTable &at, const Colour colour) {
+    return colour == WHITE ? king_danger_squares<WHITE>(bb, at)
+                           : king_danger_squares<BLACK>(bb, at);
+}
+
+bool king_in_check(const Bitboard &bb, const AttackTable &at, const Colour colour) {
+    return colour == WHITE ? king_in_check<WHITE>(bb, at) : king_in_check<BLACK>(bb, at);
+}
@@ -0,0 +1,90 @@
+#include "move_ordering.h"
+
+#include "eval.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// the bands each kind of move is scored in, history scores stay between -MAX_HISTORY and
+// MAX_HISTORY so quiet moves sit below all of these
+constexpr int HASH_MOVE { 1 << 30 };
+constexpr int CAPTURE { 1 << 28 };
+constexpr int KILLER { 1 << 27 };
+constexpr int COUNTERMOVE { 1 << 26 };
+
+} // namespace
+
+int mvv_lva(const EncodedMove move) {
+    int victim { move.captured_piece < NUM_PIECES ? eval::PIECE_VALUES[move.captured_piece] : 0 };
+    if (move.promoted_piece < NUM_PIECES) {
+        victim += eval::PIECE_VALUES[move.promoted_piece];
+    }
+    return victim * 8 - static_cast<int>(move.piece);
+}
+
+MoveOrdering::MoveOrdering(const int max_ply) :
+    killers(static_cast<std::size_t>(max_ply) + 1)
+{}
+
+void MoveOrdering::clear() {
+    std::fill(killers.begin(), killers.end(), std::array<PackedMove, 2> {});
+    history = {};
+    countermoves = {};
+}
+
+void MoveOrdering::score(const std::vector<EncodedMove> &moves, std::vector<int> &scores,
+                         const int ply, const PackedMove hash_move,
+                         const std::optional<EncodedMove> previous) const {
+    const PackedMove countermove {
+        previous ? countermoves[previous->colour][previous->piece][previous->dest_square]
+                 : PackedMove {}
+    };
+    const auto &[killer_1, killer_2] { killers[ply] };
+    scores.resize(moves.size());
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        const EncodedMove move { moves[i] };
+        const PackedMove packed { pack_move(move) };
+        if (packed == hash_move) {
+            scores[i] = HASH_MOVE;
+        } else if (!is_quiet(move)) {
+            scores[i] = CAPTURE + mvv_lva(move);
+        } else if (packed == killer_1) {
+            scores[i] = KILLER + 1;
+        } else if (packed == killer_2) {
+            scores[i] = KILLER;
+        } else if (packed == countermove) {
+            scores[i] = COUNTERMOVE;
+        } else {
+            scores[i] = history[move.colour][move.source_square][move.dest_square];
+        }
+    }
+}
+
+void MoveOrdering::add_history(const EncodedMove move, const int bonus) {
+    // pulls the entry towards +-MAX_HISTORY by less the closer it already is, so it never
+    // overflows and newer results count for more
+    int &entry { history[move.colour][move.source_square][move.dest_square] };
+    entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+}
+
+void MoveOrdering::quiet_cutoff(const EncodedMove move, const std::span<const EncodedMove> tried,
+                                const int ply, const int depth,
+                                const std::optional<EncodedMove> previous) {
+    const PackedMove packed { pack_move(move) };
+    auto &[killer_1, killer_2] { killers[ply] };
+    if (killer_1 != packed) {
+        killer_2 = killer_1;
+        killer_1 = packed;
+    }
+    if (previous) {
+        countermoves[previous->colour][previous->piece][previous->dest_square] = packed;
+    }
+
+    const int bonus { std::min(depth * depth, MAX_HISTORY / 8) };
+    add_history(move, bonus);
+    for (const auto other : tried) {
+        add_history(other, -bonus);
+    }
+}
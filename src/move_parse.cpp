@@ -109,7 +109,7 @@ std::optional<EncodedMove> parse_move_input(std::string_view input, const Board
         }
         */
         return EncodedMove(MoveType::EN_PASSANT, *source, *dest, piece,
-                           colour, dest_occupant->second, NUM_PIECES);
+                           colour, PAWN, NUM_PIECES);
         // return move_type_v::EnPassant{ common, *pawn_square };
     } else if (dest_occupant.has_value()) {
         return EncodedMove(MoveType::CAPTURE, *source, *dest, piece,
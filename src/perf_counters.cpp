@@ -0,0 +1,149 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::optional<double> PerfSample::ipc() const {
+    const auto cycles { (*this)[PerfEvent::CYCLES] };
+    const auto instructions { (*this)[PerfEvent::INSTRUCTIONS] };
+    if (!cycles || !instructions || *cycles == 0) {
+        return std::nullopt;
+    }
+    return static_cast<double>(*instructions) / *cycles;
+}
+
+#ifdef __linux__
+
+// (type, config) for each PerfEvent
+static constexpr std::array<std::pair<std::uint32_t, std::uint64_t>, NUM_PERF_EVENTS> EVENTS {{
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+}};
+
+PerfCounters::PerfCounters() {
+    fds_.fill(-1);
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = EVENTS[i].first;
+        attr.config = EVENTS[i].second;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const long fd { syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC) };
+        if (fd < 0 && error_.empty()) {
+            error_ = perf_event_name(static_cast<PerfEvent>(i));
+            error_ += ": ";
+            error_ += std::strerror(errno);
+            if (errno == EACCES || errno == EPERM) {
+                error_ += ", see /proc/sys/kernel/perf_event_paranoid";
+            }
+        }
+        fds_[i] = static_cast<int>(fd);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::available() const {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    PerfSample sample {};
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+        if (fds_[i] < 0) {
+            continue;
+        }
+        // value, time enabled, time running
+        std::array<std::uint64_t, 3> values {};
+        if (read(fds_[i], values.data(), sizeof(values)) != sizeof(values) || values[2] == 0) {
+            continue;
+        }
+        const double scale { static_cast<double>(values[1]) / values[2] };
+        sample.counts[i] = static_cast<std::uint64_t>(values[0] * scale);
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("perf events are only supported on Linux") {
+    fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const { return false; }
+
+void PerfCounters::start() {}
+
+PerfSample PerfCounters::stop() { return {}; }
+
+#endif
+
+void print_perf_sample(std::ostream &out, const PerfSample &sample, const std::uint64_t nodes) {
+    const auto flags { out.flags() };
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+        out << std::left << std::setfill(' ') << std::setw(16)
+            << perf_event_name(static_cast<PerfEvent>(i)) << std::right;
+        if (!sample.counts[i].has_value()) {
+            out << std::setw(16) << "n/a" << "\n";
+            continue;
+        }
+        out << std::setw(16) << *sample.counts[i];
+        if (nodes > 0) {
+            out << std::setw(12) << std::fixed << std::setprecision(2)
+                << static_cast<double>(*sample.counts[i]) / nodes << " per node";
+        }
+        out << "\n";
+    }
+    out << std::left << std::setw(16) << "IPC" << std::right << std::setw(16);
+    if (const auto ipc { sample.ipc() }) {
+        out << std::fixed << std::setprecision(2) << *ipc << "\n";
+    } else {
+        out << "n/a" << "\n";
+    }
+    out.flags(flags);
+}
@@ -0,0 +1,399 @@
+#include "perft.h"
+
+#include "attack_table.h"
+#include "board.h"
+#include "colour_traits.h"
+#include "masks.h"
+#include "perft_progress.h"
+#include "perft_table.h"
+#include "set_bit_iterator.h"
+#include "utility.h"
+
+#include <array>
+#include <bit>
+#include <charconv>
+
+// With pseudo-legal generation every move has to pass legal_after_pseudo before it's made or
+// counted, with legal generation that check is compiled out.
+template <GenMode Mode>
+static bool keep_move(const Board &board, const AttackTable &at, const EncodedMove move) {
+    if constexpr (Mode == GenMode::LEGAL) {
+        return true;
+    } else {
+        return legal_after_pseudo(board, at, move);
+    }
+}
+
+// Stands in for a PerftProgress when nobody's watching, so the counting compiles away
+struct NoProgress {
+    void add(std::uint64_t) {}
+};
+
+template <GenMode Mode, typename Progress>
+static std::uint64_t perft(Board &board, const AttackTable &at, const int depth,
+                           Progress &progress) {
+    if (depth == 0) {
+        progress.add(1);
+        return 1ul;
+    }
+
+    // moves at the frontier only need counting, not making, so don't bother storing them
+    if (depth == 1) {
+        std::uint64_t nodes {};
+        MoveGen::for_each<Mode>(board, at, [&](const EncodedMove move) {
+            nodes += keep_move<Mode>(board, at, move);
+        });
+        progress.add(nodes);
+        return nodes;
+    }
+
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    MoveGen::for_each<Mode>(board, at, [&](const EncodedMove move) {
+        if (keep_move<Mode>(board, at, move)) {
+            moves.push_back(move);
+        }
+    });
+    std::uint64_t nodes {};
+    for (const auto move : moves) {
+        board.make_move(move);
+        nodes += perft<Mode>(board, at, depth-1, progress);
+        board.undo_last_move();
+    }
+    return nodes;
+}
+
+template <GenMode Mode, typename Progress>
+static std::uint64_t perft(Board &board, const AttackTable &at, const int depth,
+                           PerftTable &table, const bool canonical, Progress &progress) {
+    // not worth a probe, the moves only need counting
+    if (depth <= 1) {
+        return perft<Mode>(board, at, depth, progress);
+    }
+    const std::uint64_t key { canonical ? board.canonical_key() : board.key() };
+    if (const auto cached { table.probe(key, depth) }) {
+        progress.add(*cached);
+        return *cached;
+    }
+
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    MoveGen::for_each<Mode>(board, at, [&](const EncodedMove move) {
+        if (keep_move<Mode>(board, at, move)) {
+            moves.push_back(move);
+        }
+    });
+    std::uint64_t nodes {};
+    for (const auto move : moves) {
+        board.make_move(move);
+        nodes += perft<Mode>(board, at, depth-1, table, canonical, progress);
+        board.undo_last_move();
+    }
+    table.store(key, depth, nodes);
+    return nodes;
+}
+
+// Picks the instantiation for the generation mode and whether there's a progress counter
+template <typename Count>
+static std::uint64_t dispatch(const GenMode mode, PerftProgress *progress, Count &&count) {
+    NoProgress none;
+    if (mode == GenMode::LEGAL) {
+        return progress ? count.template operator()<GenMode::LEGAL>(*progress)
+                        : count.template operator()<GenMode::LEGAL>(none);
+    }
+    return progress ? count.template operator()<GenMode::PSEUDO_LEGAL>(*progress)
+                    : count.template operator()<GenMode::PSEUDO_LEGAL>(none);
+}
+
+std::uint64_t perft(Board &board, const AttackTable &at, const int depth, const GenMode mode,
+                    PerftProgress *progress) {
+    return dispatch(mode, progress, [&]<GenMode Mode>(auto &p) {
+        return perft<Mode>(board, at, depth, p);
+    });
+}
+
+std::uint64_t perft(Board &board, const AttackTable &at, const int depth, PerftTable &table,
+                    const bool canonical, const GenMode mode, PerftProgress *progress) {
+    return dispatch(mode, progress, [&]<GenMode Mode>(auto &p) {
+        return perft<Mode>(board, at, depth, table, canonical, p);
+    });
+}
+
+PerftStats& PerftStats::operator+=(const PerftStats &other) {
+    nodes += other.nodes;
+    captures += other.captures;
+    en_passants += other.en_passants;
+    castles += other.castles;
+    promotions += other.promotions;
+    checks += other.checks;
+    discovered_checks += other.discovered_checks;
+    double_checks += other.double_checks;
+    checkmates += other.checkmates;
+    return *this;
+}
+
+// The squares of our pieces attacking the enemy king once move has been made, worked out from
+// the move and the current position instead of making it. Only the moved piece (and the rook
+// when castling) changes square, everything else can only give check by being uncovered.
+template <Colour Us>
+static std::uint64_t checkers_after(const Bitboard &bb, const AttackTable &at,
+                                    const EncodedMove move) {
+    using Traits = ColourTraits<Us>;
+    constexpr Colour Them { opposite(Us) };
+
+    const Square king_sq { from_mask(bb.colour_piece_mask(Them, KING)) };
+    const std::uint64_t king { from_square(king_sq) };
+    const auto type { static_cast<MoveType>(move.move_type) };
+    const std::uint64_t source { from_square(static_cast<Square>(move.source_square)) };
+    const std::uint64_t dest { from_square(static_cast<Square>(move.dest_square)) };
+
+    std::uint64_t occupied { (bb.entire_mask() ^ source) | dest };
+    // our pieces that haven't moved
+    std::uint64_t ours { bb.colour_mask(Us) ^ source };
+    // the square and type of the piece that moved and could now give check itself
+    Square checker_sq { static_cast<Square>(move.dest_square) };
+    Piece checker {
+        move.promoted_piece != NUM_PIECES ? static_cast<Piece>(move.promoted_piece)
+                                          : static_cast<Piece>(move.piece)
+    };
+
+    if (type == MoveType::EN_PASSANT) {
+        occupied ^= Traits::push_back(dest);
+    } else if (type == MoveType::CASTLE_KINGSIDE || type == MoveType::CASTLE_QUEENSIDE) {
+        const bool kingside { type == MoveType::CASTLE_KINGSIDE };
+        const Square rook_from { kingside ? Traits::kingside_rook : Traits::queenside_rook };
+        // the rook ends up on the square the king passed over
+        checker_sq = static_cast<Square>((Traits::king_start + move.dest_square) / 2);
+        checker = ROOK;
+        occupied ^= from_square(rook_from) | from_square(checker_sq);
+        ours ^= from_square(rook_from);
+    }
+
+    std::uint64_t checkers {};
+    if (checker == PAWN) {
+        if (Traits::pawn_attacks(from_square(checker_sq)) & king) {
+            checkers |= from_square(checker_sq);
+        }
+    } else if (checker != KING && (at.attacks(checker_sq, checker, Us, occupied) & king)) {
+        checkers |= from_square(checker_sq);
+    }
+
+    const std::uint64_t queens { bb.piece_mask(QUEEN) };
+    checkers |= at.attacks(king_sq, BISHOP, Them, occupied) & ours &
+                (bb.piece_mask(BISHOP) | queens);
+    checkers |= at.attacks(king_sq, ROOK, Them, occupied) & ours &
+                (bb.piece_mask(ROOK) | queens);
+    return checkers;
+}
+
+// Per position, what a move has to do to give check: land on a square its piece attacks the
+// enemy king from, or move the only piece between one of our sliders and the king. Lets most
+// moves be ruled out without working out the position after them.
+struct CheckHints {
+    std::array<std::uint64_t, NUM_PIECES> check_squares;
+    std::uint64_t discoverers;
+};
+
+template <Colour Us>
+static CheckHints check_hints(const Bitboard &bb, const AttackTable &at) {
+    constexpr Colour Them { opposite(Us) };
+    const std::uint64_t king { bb.colour_piece_mask(Them, KING) };
+    const Square king_sq { from_mask(king) };
+    const std::uint64_t occupied { bb.entire_mask() };
+    const std::uint64_t ours { bb.colour_mask(Us) };
+    const std::uint64_t bishop { at.attacks(king_sq, BISHOP, Them, occupied) };
+    const std::uint64_t rook { at.attacks(king_sq, ROOK, Them, occupied) };
+
+    CheckHints hints {};
+    hints.check_squares[PAWN] = ColourTraits<Them>::pawn_attacks(king);
+    hints.check_squares[KNIGHT] = at.attacks(king_sq, KNIGHT, Them, occupied);
+    hints.check_squares[BISHOP] = bishop;
+    hints.check_squares[ROOK] = rook;
+    hints.check_squares[QUEEN] = bishop | rook;
+
+    // our sliders that would see the king if our pieces nearest the king weren't there
+    const std::uint64_t queens { bb.colour_piece_mask(Us, QUEEN) };
+    const std::uint64_t xray_bishops {
+        at.attacks(king_sq, BISHOP, Them, occupied ^ (bishop & ours)) & ~bishop &
+        (bb.colour_piece_mask(Us, BISHOP) | queens)
+    };
+    const std::uint64_t xray_rooks {
+        at.attacks(king_sq, ROOK, Them, occupied ^ (rook & ours)) & ~rook &
+        (bb.colour_piece_mask(Us, ROOK) | queens)
+    };
+    for (const auto slider : SetBits(xray_bishops | xray_rooks)) {
+        const Square slider_sq { from_mask(slider) };
+        hints.discoverers |= direction::SOURCE_DEST_MASKS[king_sq][slider_sq] &
+                             direction::SOURCE_DEST_MASKS[slider_sq][king_sq] & ours;
+    }
+    return hints;
+}
+
+template <Colour Us>
+static void count_move_stats(Board &board, const AttackTable &at, const CheckHints &hints,
+                             const EncodedMove move, PerftStats &stats) {
+    ++stats.nodes;
+    const auto type { static_cast<MoveType>(move.move_type) };
+    switch (type) {
+        case MoveType::QUIET:
+        case MoveType::DOUBLE_PAWN_PUSH:
+        case MoveType::CAPTURE: {
+            stats.captures += type == MoveType::CAPTURE;
+            // the piece moves in a straight line from one square to another and keeps its
+            // type, so it can only give check through one of the hints
+            const std::uint64_t source { from_square(static_cast<Square>(move.source_square)) };
+            const std::uint64_t dest { from_square(static_cast<Square>(move.dest_square)) };
+            if (!(source & hints.discoverers) && !(dest & hints.check_squares[move.piece])) {
+                return;
+            }
+            break;
+        }
+        case MoveType::EN_PASSANT:
+            ++stats.captures;
+            ++stats.en_passants;
+            break;
+        case MoveType::CASTLE_KINGSIDE:
+        case MoveType::CASTLE_QUEENSIDE:
+            ++stats.castles;
+            break;
+        case MoveType::MOVE_PROMOTION:
+            ++stats.promotions;
+            break;
+        case MoveType::CAPTURE_PROMOTION:
+            ++stats.captures;
+            ++stats.promotions;
+            break;
+        default:
+            break;
+    }
+
+    const std::uint64_t checkers { checkers_after<Us>(board.bitboard(), at, move) };
+    if (!checkers) {
+        return;
+    }
+    ++stats.checks;
+    // castling puts the rook on a square that isn't the move's destination, but the rook is
+    // still the moved piece rather than an uncovered one
+    const bool castle { type == MoveType::CASTLE_KINGSIDE || type == MoveType::CASTLE_QUEENSIDE };
+    const std::uint64_t moved {
+        castle ? from_square(static_cast<Square>(
+                     (move.source_square + move.dest_square) / 2))
+               : from_square(static_cast<Square>(move.dest_square))
+    };
+    if (std::popcount(checkers) > 1) {
+        ++stats.double_checks;
+    } else if (checkers & ~moved) {
+        ++stats.discovered_checks;
+    }
+
+    // checks are rare enough that making the move to look for mate doesn't show up
+    board.make_move(move);
+    if (!has_legal_move(board, at)) {
+        ++stats.checkmates;
+    }
+    board.undo_last_move();
+}
+
+void count_move_stats(Board &board, const AttackTable &at, const EncodedMove move,
+                      PerftStats &stats) {
+    if (board.turn_colour() == WHITE) {
+        count_move_stats<WHITE>(board, at, check_hints<WHITE>(board.bitboard(), at), move, stats);
+    } else {
+        count_move_stats<BLACK>(board, at, check_hints<BLACK>(board.bitboard(), at), move, stats);
+    }
+}
+
+template <Colour Us>
+static void perft_stats(Board &board, const AttackTable &at, const int depth,
+                        std::span<PerftStats> by_ply) {
+    constexpr Colour Them { opposite(Us) };
+    const CheckHints hints { check_hints<Us>(board.bitboard(), at) };
+
+    // moves at the frontier are only classified, not made
+    if (depth == 1) {
+        MoveGen::for_each(board, at, [&](const EncodedMove move) {
+            count_move_stats<Us>(board, at, hints, move, by_ply[0]);
+        });
+        return;
+    }
+
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    MoveGen(moves, board, at).gen();
+    for (const auto move : moves) {
+        count_move_stats<Us>(board, at, hints, move, by_ply[0]);
+        board.make_move(move);
+        perft_stats<Them>(board, at, depth-1, by_ply.subspan(1));
+        board.undo_last_move();
+    }
+}
+
+void perft_stats(Board &board, const AttackTable &at, const int depth,
+                 std::span<PerftStats> by_ply) {
+    if (depth == 0) {
+        return;
+    }
+    BOOST_ASSERT(by_ply.size() >= static_cast<std::size_t>(depth));
+    if (board.turn_colour() == WHITE) {
+        perft_stats<WHITE>(board, at, depth, by_ply);
+    } else {
+        perft_stats<BLACK>(board, at, depth, by_ply);
+    }
+}
+
+std::optional<GenMode> parse_gen_mode(std::string_view name) {
+    if (name == "legal") {
+        return GenMode::LEGAL;
+    }
+    if (name == "pseudo") {
+        return GenMode::PSEUDO_LEGAL;
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+static std::optional<T> parse_number(std::string_view s) {
+    T value {};
+    const auto [end, error] { std::from_chars(s.data(), s.data() + s.size(), value) };
+    if (error != std::errc {} || end != s.data() + s.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<EpdEntry> parse_epd_line(std::string_view line) {
+    const auto fields { utility::split(line, ';') };
+    if (fields.empty()) {
+        return std::nullopt;
+    }
+
+    EpdEntry entry;
+    // strip the trailing space left between the FEN and the first ';'
+    std::string_view fen { fields.front() };
+    while (!fen.empty() && (fen.back() == ' ' || fen.back() == '\t' || fen.back() == '\r')) {
+        fen.remove_suffix(1);
+    }
+    if (fen.empty()) {
+        return std::nullopt;
+    }
+    entry.fen = fen;
+
+    for (std::size_t i = 1; i < fields.size(); ++i) {
+        // each field is "D<depth> <nodes>"
+        const auto tokens { utility::split(fields[i], ' ') };
+        if (tokens.size() != 2 || tokens[0].size() < 2 || tokens[0].front() != 'D') {
+            return std::nullopt;
+        }
+        std::string_view nodes_str { tokens[1] };
+        if (!nodes_str.empty() && nodes_str.back() == '\r') {
+            nodes_str.remove_suffix(1);
+        }
+        const auto depth { parse_number<int>(tokens[0].substr(1)) };
+        const auto nodes { parse_number<std::uint64_t>(nodes_str) };
+        if (!depth.has_value() || !nodes.has_value() || *depth < 1) {
+            return std::nullopt;
+        }
+        entry.expected.emplace_back(*depth, *nodes);
+    }
+    return entry;
+}
@@ -4,7 +4,12 @@
 #include "board.h"
 #include "decoded_move.h"
 #include "move_gen.h"
+#include "perf_counters.h"
+#include "perft.h"
 
+#include <algorithm>
+#include <iterator>
+#include <string>
 #include <vector>
 #include <string_view>
 #include <utility>
@@ -183,6 +188,184 @@ static void BM_board_gen_moves(benchmark::State &state) {
     }
 }
 
+static void BM_board_count_moves(benchmark::State &state) {
+    const AttackTable at {};
+    Board board { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    for (auto _ : state) {
+        std::size_t count {};
+        MoveGen::for_each(board, at, [&count](const EncodedMove) {
+            ++count;
+        });
+        benchmark::DoNotOptimize(count);
+    }
+}
+
+static void BM_board_has_legal_move(benchmark::State &state) {
+    const AttackTable at {};
+    Board board { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(has_legal_move(board, at));
+    }
+}
+
+// A mix of moves that are legal in Kiwipete and moves taken from one of its child positions,
+// which is what validating hash and killer moves looks like
+static std::vector<EncodedMove> legality_candidates(const Board &board, const AttackTable &at) {
+    std::vector<EncodedMove> legal;
+    MoveGen(legal, board, at).gen();
+    Board child { board };
+    child.make_move(legal.front());
+    child.make_move(*first_legal_move(child, at));
+    std::vector<EncodedMove> candidates;
+    MoveGen(candidates, child, at).gen();
+    for (std::size_t i = 0; i < legal.size(); i += 2) {
+        candidates.push_back(legal[i]);
+    }
+    return candidates;
+}
+
+static void BM_is_legal(benchmark::State &state) {
+    const AttackTable at {};
+    Board board { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    const auto candidates { legality_candidates(board, at) };
+    for (auto _ : state) {
+        for (const auto move : candidates) {
+            benchmark::DoNotOptimize(is_legal(board, at, move));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+
+static void BM_is_legal_by_generation(benchmark::State &state) {
+    const AttackTable at {};
+    Board board { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    const auto candidates { legality_candidates(board, at) };
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    for (auto _ : state) {
+        for (const auto move : candidates) {
+            MoveGen(moves, board, at).gen();
+            benchmark::DoNotOptimize(std::find(moves.begin(), moves.end(), move) != moves.end());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+
+// Hardware counters over a benchmark's timed loop, added to its output per item processed.
+// Construct it just before the loop. Nothing's added if the counters aren't available.
+class BenchCounters {
+public:
+    BenchCounters() { counters.start(); }
+
+    void report(benchmark::State &state, const std::uint64_t items) {
+        const PerfSample sample { counters.stop() };
+        if (items == 0) {
+            return;
+        }
+        for (std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            if (sample.counts[i].has_value()) {
+                state.counters[perf_event_name(static_cast<PerfEvent>(i))] =
+                    static_cast<double>(*sample.counts[i]) / items;
+            }
+        }
+        if (const auto ipc { sample.ipc() }) {
+            state.counters["IPC"] = *ipc;
+        }
+    }
+private:
+    PerfCounters counters;
+};
+
+// Positions for comparing legal against pseudo-legal generation, the trade-off depends on how
+// many pins and checks there are to deal with
+static constexpr std::pair<std::string_view, std::string_view> STRATEGY_POSITIONS[] {
+    { "quiet", "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1" },
+    { "tactical", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -" },
+    { "pinned", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" },
+    { "in-check", "rnbqk1nr/pppp1ppp/8/4p3/1b1PP3/8/PPP2PPP/RNBQKBNR w KQkq - 1 3" },
+    { "endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -" },
+};
+
+static void BM_count_legal(benchmark::State &state) {
+    const AttackTable at {};
+    const auto [label, fen] { STRATEGY_POSITIONS[state.range(0)] };
+    Board board { *Board::init(fen) };
+    BenchCounters counters;
+    for (auto _ : state) {
+        std::size_t count {};
+        MoveGen::for_each(board, at, [&count](const EncodedMove) {
+            ++count;
+        });
+        benchmark::DoNotOptimize(count);
+    }
+    counters.report(state, state.iterations());
+    state.SetLabel(std::string(label));
+}
+
+static void BM_count_pseudo_legal_filtered(benchmark::State &state) {
+    const AttackTable at {};
+    const auto [label, fen] { STRATEGY_POSITIONS[state.range(0)] };
+    Board board { *Board::init(fen) };
+    BenchCounters counters;
+    for (auto _ : state) {
+        std::size_t count {};
+        MoveGen::for_each<GenMode::PSEUDO_LEGAL>(board, at, [&](const EncodedMove move) {
+            count += legal_after_pseudo(board, at, move);
+        });
+        benchmark::DoNotOptimize(count);
+    }
+    counters.report(state, state.iterations());
+    state.SetLabel(std::string(label));
+}
+
+// A whole perft, so the counters are per node and include make/unmake
+static void BM_perft(benchmark::State &state) {
+    const AttackTable at {};
+    const auto [label, fen] { STRATEGY_POSITIONS[state.range(0)] };
+    Board board { *Board::init(fen) };
+    std::uint64_t nodes {};
+    BenchCounters counters;
+    for (auto _ : state) {
+        nodes += perft(board, at, 3);
+    }
+    counters.report(state, nodes);
+    state.SetItemsProcessed(nodes);
+    state.SetLabel(std::string(label));
+}
+
+// What a search gets out of pseudo-legal generation on a cut node, only the first move needs
+// its legality checking
+static void BM_gen_pseudo_legal_check_first(benchmark::State &state) {
+    const AttackTable at {};
+    const auto [label, fen] { STRATEGY_POSITIONS[state.range(0)] };
+    Board board { *Board::init(fen) };
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    for (auto _ : state) {
+        MoveGen(moves, board, at).gen_pseudo_legal();
+        const auto first {
+            std::find_if(moves.begin(), moves.end(), [&](const EncodedMove move) {
+                return legal_after_pseudo(board, at, move);
+            })
+        };
+        benchmark::DoNotOptimize(first);
+    }
+    state.SetLabel(std::string(label));
+}
+
+static void BM_gen_legal_take_first(benchmark::State &state) {
+    const AttackTable at {};
+    const auto [label, fen] { STRATEGY_POSITIONS[state.range(0)] };
+    Board board { *Board::init(fen) };
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    for (auto _ : state) {
+        MoveGen(moves, board, at).gen();
+        benchmark::DoNotOptimize(moves.front());
+    }
+    state.SetLabel(std::string(label));
+}
+
 BENCHMARK(BM_board_copy);
 BENCHMARK(BM_board_make_double_pawn_push);
 BENCHMARK(BM_board_make_quiet);
@@ -197,5 +380,14 @@ BENCHMARK(BM_board_undo_quiet);
 BENCHMARK(BM_board_undo_capture);
 BENCHMARK(BM_board_undo_castle_kingside);
 BENCHMARK(BM_board_gen_moves);
+BENCHMARK(BM_board_count_moves);
+BENCHMARK(BM_board_has_legal_move);
+BENCHMARK(BM_is_legal);
+BENCHMARK(BM_is_legal_by_generation);
+BENCHMARK(BM_count_legal)->DenseRange(0, std::size(STRATEGY_POSITIONS)-1);
+BENCHMARK(BM_count_pseudo_legal_filtered)->DenseRange(0, std::size(STRATEGY_POSITIONS)-1);
+BENCHMARK(BM_gen_legal_take_first)->DenseRange(0, std::size(STRATEGY_POSITIONS)-1);
+BENCHMARK(BM_gen_pseudo_legal_check_first)->DenseRange(0, std::size(STRATEGY_POSITIONS)-1);
+BENCHMARK(BM_perft)->DenseRange(0, std::size(STRATEGY_POSITIONS)-1);
 
 BENCHMARK_MAIN();
\ No newline at end of file
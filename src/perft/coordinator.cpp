@@ -0,0 +1,269 @@
+#include "coordinator.h"
+
+#include "attack_table.h"
+#include "board.h"
+#include "perft.h"
+
+#include <cerrno>
+#include <csignal>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <spawn.h>
+#include <sstream>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// a unit that's taken down this many workers is assumed to be the problem
+static constexpr int MAX_ATTEMPTS { 3 };
+// keep a second unit queued in each worker's pipe so it never sits idle waiting on us
+static constexpr std::size_t UNITS_IN_FLIGHT { 2 };
+
+namespace {
+
+struct Worker {
+    pid_t pid { -1 };
+    int to_worker { -1 };
+    int from_worker { -1 };
+    std::string read_buffer;
+    std::deque<std::size_t> in_flight;
+};
+
+} // namespace
+
+static std::optional<Worker> spawn_worker(const std::string &exe, const GenMode mode) {
+    int to_worker[2];
+    int from_worker[2];
+    // close-on-exec so later workers don't inherit this one's pipes, otherwise it never sees
+    // EOF on stdin. dup2 onto stdin/stdout clears the flag for the ends the worker does get.
+    if (pipe2(to_worker, O_CLOEXEC) != 0) {
+        return std::nullopt;
+    }
+    if (pipe2(from_worker, O_CLOEXEC) != 0) {
+        close(to_worker[0]);
+        close(to_worker[1]);
+        return std::nullopt;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, to_worker[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, from_worker[1], STDOUT_FILENO);
+
+    std::string strategy { mode == GenMode::LEGAL ? "legal" : "pseudo" };
+    std::string worker_flag { "--worker" };
+    std::string strategy_flag { "--strategy" };
+    std::string exe_arg { exe };
+    char *argv[] { exe_arg.data(), worker_flag.data(), strategy_flag.data(), strategy.data(),
+                   nullptr };
+
+    pid_t pid {};
+    const int error { posix_spawn(&pid, exe.c_str(), &actions, nullptr, argv, environ) };
+    posix_spawn_file_actions_destroy(&actions);
+    close(to_worker[0]);
+    close(from_worker[1]);
+    if (error != 0) {
+        close(to_worker[1]);
+        close(from_worker[0]);
+        return std::nullopt;
+    }
+
+    Worker worker;
+    worker.pid = pid;
+    worker.to_worker = to_worker[1];
+    worker.from_worker = from_worker[0];
+    return worker;
+}
+
+static void retire_worker(Worker &worker) {
+    if (worker.to_worker >= 0) {
+        close(worker.to_worker);
+    }
+    if (worker.from_worker >= 0) {
+        close(worker.from_worker);
+    }
+    if (worker.pid > 0) {
+        waitpid(worker.pid, nullptr, 0);
+    }
+    worker.to_worker = -1;
+    worker.from_worker = -1;
+    worker.pid = -1;
+}
+
+static bool write_all(const int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t written { write(fd, data.data(), data.size()) };
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+std::optional<std::vector<std::uint64_t>> run_distributed(const std::vector<WorkUnit> &units,
+                                                          const std::string &worker_exe,
+                                                          const unsigned processes,
+                                                          const GenMode mode) {
+    if (units.empty()) {
+        return std::vector<std::uint64_t> {};
+    }
+    // a dead worker shows up as a failed write or EOF, not a signal
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::uint64_t> results(units.size());
+    std::vector<int> attempts(units.size());
+    std::deque<std::size_t> pending;
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        pending.push_back(i);
+    }
+    std::size_t remaining { units.size() };
+
+    std::vector<Worker> workers;
+    for (unsigned i = 0; i < processes; ++i) {
+        auto worker { spawn_worker(worker_exe, mode) };
+        if (!worker.has_value()) {
+            std::cerr << "Error: couldn't start worker process \"" << worker_exe << "\"\n";
+            for (auto &w : workers) {
+                retire_worker(w);
+            }
+            return std::nullopt;
+        }
+        workers.push_back(std::move(*worker));
+    }
+
+    bool failed {};
+    // Hands a dead worker's units back to the front of the queue, in the same order, and
+    // replaces it. Units are worked through in the order they were sent, so only the first
+    // can have had anything to do with it dying, the rest hadn't been started.
+    const auto replace { [&](Worker &worker) {
+        std::cerr << "Worker " << worker.pid << " failed, reassigning "
+                  << worker.in_flight.size() << " unit(s)\n";
+        if (!worker.in_flight.empty()) {
+            const auto id { worker.in_flight.front() };
+            if (++attempts[id] >= MAX_ATTEMPTS) {
+                std::cerr << "Error: unit \"" << units[id].fen << "\" depth " << units[id].depth
+                          << " failed " << MAX_ATTEMPTS << " times\n";
+                failed = true;
+            }
+        }
+        pending.insert(pending.begin(), worker.in_flight.begin(), worker.in_flight.end());
+        worker.in_flight.clear();
+        retire_worker(worker);
+        if (!failed) {
+            auto replacement { spawn_worker(worker_exe, mode) };
+            if (replacement.has_value()) {
+                worker = std::move(*replacement);
+            } else {
+                failed = true;
+            }
+        }
+    } };
+
+    while (remaining > 0 && !failed) {
+        for (auto &worker : workers) {
+            while (worker.pid > 0 && !pending.empty() &&
+                   worker.in_flight.size() < UNITS_IN_FLIGHT) {
+                const auto id { pending.front() };
+                pending.pop_front();
+                worker.in_flight.push_back(id);
+                const std::string line {
+                    std::to_string(id) + " " + std::to_string(units[id].depth) + " " +
+                    units[id].fen + "\n"
+                };
+                if (!write_all(worker.to_worker, line)) {
+                    replace(worker);
+                    break;
+                }
+            }
+        }
+        if (failed) {
+            break;
+        }
+
+        std::vector<pollfd> fds;
+        for (const auto &worker : workers) {
+            fds.push_back(pollfd { worker.from_worker, POLLIN, 0 });
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = true;
+            break;
+        }
+
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Worker &worker { workers[i] };
+            char buffer[4096];
+            const ssize_t n { read(worker.from_worker, buffer, sizeof(buffer)) };
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                replace(worker);
+                continue;
+            }
+            worker.read_buffer.append(buffer, static_cast<std::size_t>(n));
+
+            std::size_t newline {};
+            while ((newline = worker.read_buffer.find('\n')) != std::string::npos) {
+                std::istringstream line { worker.read_buffer.substr(0, newline) };
+                worker.read_buffer.erase(0, newline + 1);
+                std::size_t id {};
+                std::uint64_t nodes {};
+                // units are answered in the order they were sent
+                if (!(line >> id >> nodes) || worker.in_flight.empty() ||
+                    worker.in_flight.front() != id) {
+                    replace(worker);
+                    break;
+                }
+                worker.in_flight.pop_front();
+                results[id] = nodes;
+                --remaining;
+            }
+        }
+    }
+
+    for (auto &worker : workers) {
+        retire_worker(worker);
+    }
+    if (failed) {
+        return std::nullopt;
+    }
+    return results;
+}
+
+int run_worker(const GenMode mode) {
+    const AttackTable at {};
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in { line };
+        std::size_t id {};
+        int depth {};
+        if (!(in >> id >> depth)) {
+            std::cerr << "Error: invalid work unit \"" << line << "\"\n";
+            return 1;
+        }
+        std::string fen;
+        std::getline(in >> std::ws, fen);
+        auto board { Board::init(fen) };
+        if (!board.has_value()) {
+            std::cerr << "Error: Invalid fen string \"" << fen << "\"\n";
+            return 1;
+        }
+        // flushed per unit, the coordinator is waiting on it
+        std::cout << id << " " << perft(*board, at, depth, mode) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "move_gen.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Multi-process perft. The coordinator expands the tree to a split depth and hands each
+// position below it to a pool of worker processes (the same binary run with --worker) over
+// pipes. A worker that dies has its units given to a replacement, so one crash doesn't take
+// the whole run down with it.
+
+struct WorkUnit {
+    // which root move the unit's count belongs to
+    std::size_t root_index;
+    std::string fen;
+    int depth;
+};
+
+// Returns the count for each unit, in the same order, or std::nullopt if a unit kept failing.
+std::optional<std::vector<std::uint64_t>> run_distributed(const std::vector<WorkUnit> &units,
+                                                          const std::string &worker_exe,
+                                                          const unsigned processes,
+                                                          const GenMode mode);
+
+// Worker side. Reads "<id> <depth> <fen>" lines from stdin and writes "<id> <nodes>" lines to
+// stdout until stdin is closed.
+int run_worker(const GenMode mode);
@@ -0,0 +1,303 @@
+#include "attack_table.h"
+#include "board.h"
+#include "perft.h"
+#include "trace.h"
+
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+
+// Streams positions from an EPD/FEN file through a pool of threads sharing one AttackTable.
+// Each output line is the position with the counts that were computed, in EPD format and in
+// input order, so the output can be fed back in as a suite. Lines with expected counts are
+// checked against them, plain FEN lines are counted to --depth.
+
+struct BatchArgs {
+    std::string input;
+    std::optional<std::string> output;
+    int depth;
+    int max_depth;
+    unsigned threads;
+    GenMode strategy;
+    std::optional<std::string> trace;
+};
+
+std::optional<BatchArgs> parse_args(int argc, char **argv) {
+    po::options_description desc("Allowed Options");
+    desc.add_options()
+        ("input", po::value<std::string>()->required(),
+            "EPD or FEN file, one position per line, - for stdin")
+        ("output", po::value<std::string>(), "file to write results to, defaults to stdout")
+        ("depth", po::value<int>()->default_value(0),
+            "depth to count positions with no expected counts to")
+        ("max-depth", po::value<int>()->default_value(0),
+            "skip expected counts deeper than this, 0 runs everything")
+        ("threads", po::value<unsigned>()->default_value(std::thread::hardware_concurrency()),
+            "number of worker threads")
+        ("strategy", po::value<std::string>()->default_value("legal"),
+            "move generation strategy, either \"legal\" or \"pseudo\"")
+        ("trace", po::value<std::string>(),
+            "write a timeline of every thread's work to this file, as Chrome trace-event JSON");
+    po::positional_options_description positional;
+    positional.add("input", 1);
+
+    try {
+        po::variables_map vm;
+        po::store(
+            po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm
+        );
+        po::notify(vm);
+
+        const std::string strategy { vm["strategy"].as<std::string>() };
+        const auto mode { parse_gen_mode(strategy) };
+        if (!mode.has_value()) {
+            std::cerr << "Error: unknown strategy \"" << strategy << "\"\n";
+            return std::nullopt;
+        }
+
+        std::optional<std::string> output;
+        if (vm.count("output")) {
+            output = vm["output"].as<std::string>();
+        }
+
+        std::optional<std::string> trace;
+        if (vm.count("trace")) {
+            trace = vm["trace"].as<std::string>();
+        }
+
+        return BatchArgs {
+            vm["input"].as<std::string>(),
+            output,
+            vm["depth"].as<int>(),
+            vm["max-depth"].as<int>(),
+            std::max(1u, vm["threads"].as<unsigned>()),
+            *mode,
+            trace
+        };
+    } catch (const std::exception &e) {
+        std::cerr << desc << "\n";
+        return std::nullopt;
+    } catch (...) {
+        std::cerr << desc << "\n";
+        return std::nullopt;
+    }
+}
+
+struct Job {
+    std::size_t index;
+    std::size_t line_num;
+    EpdEntry entry;
+};
+
+struct JobResult {
+    std::string line;
+    std::uint64_t nodes;
+    bool failed;
+};
+
+// Jobs go in in input order and results come out in input order, whatever order the workers
+// finish them in. Only a window of positions can be in flight at once so a slow position
+// can't make the reorder buffer grow without bound.
+class BatchQueue {
+public:
+    BatchQueue(std::ostream &out, const std::size_t window) : out(out), window(window) {}
+
+    void push(Job job) {
+        const trace::Scope scope { "wait for space", "wait" };
+        std::unique_lock lock(mutex);
+        space_available.wait(lock, [&] { return job.index - next_to_write < window; });
+        jobs.push_back(std::move(job));
+        job_available.notify_one();
+    }
+
+    std::optional<Job> pop() {
+        const trace::Scope scope { "wait for job", "wait" };
+        std::unique_lock lock(mutex);
+        job_available.wait(lock, [&] { return !jobs.empty() || finished; });
+        if (jobs.empty()) {
+            return std::nullopt;
+        }
+        Job job { std::move(jobs.front()) };
+        jobs.pop_front();
+        return job;
+    }
+
+    void complete(const std::size_t index, JobResult result) {
+        std::lock_guard lock(mutex);
+        ready.emplace(index, std::move(result));
+        // write out everything that's now contiguous with what's already been written
+        auto it { ready.begin() };
+        while (it != ready.end() && it->first == next_to_write) {
+            out << it->second.line << "\n";
+            total_nodes += it->second.nodes;
+            failed += it->second.failed;
+            it = ready.erase(it);
+            ++next_to_write;
+        }
+        space_available.notify_one();
+    }
+
+    // no more jobs are coming, idle workers can exit
+    void finish() {
+        std::lock_guard lock(mutex);
+        finished = true;
+        job_available.notify_all();
+    }
+
+    std::uint64_t nodes() const { return total_nodes; }
+    std::size_t failures() const { return failed; }
+private:
+    std::ostream &out;
+    const std::size_t window;
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable space_available;
+    std::deque<Job> jobs;
+    std::map<std::size_t, JobResult> ready;
+    std::size_t next_to_write {};
+    bool finished {};
+    std::uint64_t total_nodes {};
+    std::size_t failed {};
+};
+
+static JobResult run_job(const Job &job, const AttackTable &at, const BatchArgs &args) {
+    auto board { Board::init(job.entry.fen) };
+    if (!board.has_value()) {
+        std::ostringstream err;
+        err << "Error: line " << job.line_num << " has an invalid fen string\n";
+        std::cerr << err.str();
+        return JobResult { job.entry.fen + " ;error invalid fen", 0, true };
+    }
+
+    std::ostringstream line;
+    line << job.entry.fen;
+    std::uint64_t nodes {};
+    bool failed {};
+    const auto count { [&](const int depth) {
+        const auto result { perft(*board, at, depth, args.strategy) };
+        line << " ;D" << depth << " " << result;
+        nodes += result;
+        return result;
+    } };
+
+    if (job.entry.expected.empty()) {
+        count(args.depth);
+    }
+    for (const auto &[depth, expected] : job.entry.expected) {
+        if (args.max_depth > 0 && depth > args.max_depth) {
+            continue;
+        }
+        const auto result { count(depth) };
+        if (result != expected) {
+            failed = true;
+            std::ostringstream err;
+            err << "Error: line " << job.line_num << " D" << depth << " counted " << result
+                << ", expected " << expected << "\n";
+            std::cerr << err.str();
+        }
+    }
+    return JobResult { line.str(), nodes, failed };
+}
+
+int main(int argc, char **argv) {
+    const auto args { parse_args(argc, argv) };
+    if (!args.has_value()) {
+        return 1;
+    }
+
+    std::ifstream input_file;
+    if (args->input != "-") {
+        input_file.open(args->input);
+        if (!input_file) {
+            std::cerr << "Error: couldn't open \"" << args->input << "\"\n";
+            return 1;
+        }
+    }
+    std::istream &input { args->input == "-" ? std::cin : input_file };
+
+    std::ofstream output_file;
+    if (args->output.has_value()) {
+        output_file.open(*args->output);
+        if (!output_file) {
+            std::cerr << "Error: couldn't open \"" << *args->output << "\" for writing\n";
+            return 1;
+        }
+    }
+    std::ostream &output { args->output.has_value() ? output_file : std::cout };
+
+    trace::Output trace_output { args->trace, "reader" };
+
+    // the table is built once for every position, that's the point of batching
+    const AttackTable at {};
+    const auto t0 { std::chrono::steady_clock::now() };
+    BatchQueue queue(output, args->threads * 64);
+
+    std::vector<std::jthread> workers;
+    for (unsigned i = 0; i < args->threads; ++i) {
+        workers.emplace_back([&, i] {
+            trace::set_thread_name("worker " + std::to_string(i));
+            while (auto job { queue.pop() }) {
+                const trace::Scope scope { "position", "task", "line", job->line_num };
+                queue.complete(job->index, run_job(*job, at, *args));
+            }
+        });
+    }
+
+    std::size_t positions {};
+    std::size_t line_num {};
+    bool bad_input {};
+    std::string line;
+    while (std::getline(input, line)) {
+        ++line_num;
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line.front() == '#') {
+            continue;
+        }
+        auto entry { parse_epd_line(line) };
+        if (!entry.has_value()) {
+            std::cerr << "Error: line " << line_num << " is not a valid EPD line\n";
+            bad_input = true;
+            break;
+        }
+        if (entry->expected.empty() && args->depth < 1) {
+            std::cerr << "Error: line " << line_num << " has no counts and no --depth given\n";
+            bad_input = true;
+            break;
+        }
+        queue.push(Job { positions++, line_num, std::move(*entry) });
+    }
+    queue.finish();
+    workers.clear();
+    output.flush();
+
+    const auto t1 { std::chrono::steady_clock::now() };
+    const auto us { std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count() };
+    const double secs { static_cast<double>(us) / 1'000'000 };
+    // throughput goes to stderr so stdout is only results
+    std::cerr << positions << " positions, " << queue.nodes() << " nodes in " << secs << "s on "
+              << args->threads << " threads, "
+              << static_cast<std::uint64_t>(secs > 0 ? positions / secs : 0)
+              << " positions per second";
+    if (queue.failures()) {
+        std::cerr << ", " << queue.failures() << " failed";
+    }
+    std::cerr << "\n";
+    return trace_output.finish(bad_input || queue.failures() ? 1 : 0);
+}
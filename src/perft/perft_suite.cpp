@@ -0,0 +1,221 @@
+#include "attack_table.h"
+#include "board.h"
+#include "perft.h"
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+
+#ifndef FENRIR_STANDARD_EPD
+#define FENRIR_STANDARD_EPD "standard.epd"
+#endif
+
+struct SuiteArgs {
+    std::string epd;
+    int max_depth;
+    GenMode strategy;
+    std::optional<std::string> json;
+};
+
+struct SuiteResult {
+    std::string fen;
+    int depth;
+    std::uint64_t expected;
+    std::uint64_t nodes;
+    std::uint64_t us;
+};
+
+std::optional<SuiteArgs> parse_args(int argc, char **argv) {
+    po::options_description desc("Allowed Options");
+    desc.add_options()
+        ("epd", po::value<std::string>()->default_value(FENRIR_STANDARD_EPD),
+            "EPD file of positions and their expected node counts")
+        ("max-depth", po::value<int>()->default_value(0),
+            "skip counts deeper than this, 0 runs everything")
+        ("strategy", po::value<std::string>()->default_value("legal"),
+            "move generation strategy, either \"legal\" or \"pseudo\"")
+        ("json", po::value<std::string>(), "also write a JSON summary to this file");
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+
+        const std::string strategy { vm["strategy"].as<std::string>() };
+        const auto mode { parse_gen_mode(strategy) };
+        if (!mode.has_value()) {
+            std::cerr << "Error: unknown strategy \"" << strategy << "\"\n";
+            return std::nullopt;
+        }
+
+        std::optional<std::string> json;
+        if (vm.count("json")) {
+            json = vm["json"].as<std::string>();
+        }
+
+        return SuiteArgs {
+            vm["epd"].as<std::string>(),
+            vm["max-depth"].as<int>(),
+            *mode,
+            json
+        };
+    } catch (const std::exception &e) {
+        std::cerr << desc << "\n";
+        return std::nullopt;
+    } catch (...) {
+        std::cerr << desc << "\n";
+        return std::nullopt;
+    }
+}
+
+static std::optional<std::vector<EpdEntry>> read_epd(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: couldn't open \"" << path << "\"\n";
+        return std::nullopt;
+    }
+
+    std::vector<EpdEntry> entries;
+    std::string line;
+    int line_num {};
+    while (std::getline(file, line)) {
+        ++line_num;
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line.front() == '#') {
+            continue;
+        }
+        auto entry { parse_epd_line(line) };
+        if (!entry.has_value()) {
+            std::cerr << "Error: " << path << ":" << line_num << " is not a valid EPD line\n";
+            return std::nullopt;
+        }
+        entries.push_back(std::move(*entry));
+    }
+    return entries;
+}
+
+static std::uint64_t nps(const std::uint64_t nodes, const std::uint64_t us) {
+    return us ? nodes * 1'000'000 / us : 0;
+}
+
+static std::string seconds(const std::uint64_t us) {
+    std::ostringstream ss;
+    ss << us / 1'000'000 << "." << std::setw(3) << std::setfill('0') << us / 1000 % 1000 << "s";
+    return ss.str();
+}
+
+static std::string json_string(const std::string_view s) {
+    std::string rv { "\"" };
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            rv += '\\';
+        }
+        rv += c;
+    }
+    return rv + "\"";
+}
+
+static bool write_json(const std::string &path, const SuiteArgs &args,
+                       const std::vector<SuiteResult> &results, const std::uint64_t total_us) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error: couldn't open \"" << path << "\" for writing\n";
+        return false;
+    }
+
+    std::uint64_t total_nodes {};
+    std::size_t failed {};
+    file << "{\n"
+         << "  \"epd\": " << json_string(args.epd) << ",\n"
+         << "  \"strategy\": "
+         << (args.strategy == GenMode::LEGAL ? "\"legal\"" : "\"pseudo\"") << ",\n"
+         << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto &r { results[i] };
+        total_nodes += r.nodes;
+        failed += r.nodes != r.expected;
+        file << "    { \"fen\": " << json_string(r.fen)
+             << ", \"depth\": " << r.depth
+             << ", \"expected\": " << r.expected
+             << ", \"nodes\": " << r.nodes
+             << ", \"pass\": " << (r.nodes == r.expected ? "true" : "false")
+             << ", \"us\": " << r.us
+             << ", \"nps\": " << nps(r.nodes, r.us) << " }"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ],\n"
+         << "  \"total_nodes\": " << total_nodes << ",\n"
+         << "  \"total_us\": " << total_us << ",\n"
+         << "  \"nps\": " << nps(total_nodes, total_us) << ",\n"
+         << "  \"failed\": " << failed << "\n"
+         << "}\n";
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const auto args { parse_args(argc, argv) };
+    if (!args.has_value()) {
+        return 1;
+    }
+
+    const auto entries { read_epd(args->epd) };
+    if (!entries.has_value()) {
+        return 1;
+    }
+
+    const AttackTable at {};
+    std::vector<SuiteResult> results;
+    std::uint64_t total_nodes {};
+    std::uint64_t total_us {};
+    std::size_t failed {};
+
+    for (const auto &entry : *entries) {
+        auto board { Board::init(entry.fen) };
+        if (!board.has_value()) {
+            std::cerr << "Error: Invalid fen string \"" << entry.fen << "\"\n";
+            return 1;
+        }
+
+        for (const auto &[depth, expected] : entry.expected) {
+            if (args->max_depth > 0 && depth > args->max_depth) {
+                continue;
+            }
+            const auto t0 { std::chrono::steady_clock::now() };
+            const auto nodes { perft(*board, at, depth, args->strategy) };
+            const auto t1 { std::chrono::steady_clock::now() };
+            const std::uint64_t us {
+                static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count())
+            };
+            results.push_back(SuiteResult { entry.fen, depth, expected, nodes, us });
+            total_nodes += nodes;
+            total_us += us;
+
+            const bool pass { nodes == expected };
+            failed += !pass;
+            std::cout << (pass ? "OK   " : "FAIL ") << entry.fen << " D" << depth
+                      << " " << nodes;
+            if (!pass) {
+                std::cout << " (expected " << expected << ")";
+            }
+            std::cout << " " << seconds(us) << " " << nps(nodes, us) << " nps\n";
+        }
+    }
+
+    std::cout << "\n" << results.size() - failed << "/" << results.size() << " passed\n"
+              << total_nodes << " nodes in " << seconds(total_us) << ", "
+              << nps(total_nodes, total_us) << " nodes per second\n";
+
+    if (args->json.has_value() && !write_json(*args->json, *args, results, total_us)) {
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -1,17 +1,28 @@
 #include "attack_table.h"
+#include "coordinator.h"
 #include "board.h"
 #include "move_gen.h"
 #include "move_parse.h"
+#include "perf_counters.h"
+#include "perft.h"
+#include "perft_checkpoint.h"
+#include "perft_progress.h"
+#include "perft_table.h"
+#include "trace.h"
+#include "unique_positions.h"
 #include "utility.h"
 
 #include <algorithm>
 #include <boost/program_options.hpp>
 #include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <optional>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace po = boost::program_options;
@@ -20,18 +31,70 @@ struct PerftArgs {
     int depth;
     std::string fen;
     std::vector<std::string> moves;
+    GenMode strategy;
+    std::optional<std::string> checkpoint;
+    int checkpoint_depth;
+    bool resume;
+    bool worker;
+    unsigned processes;
+    int split_depth;
+    bool stats;
+    bool unique;
+    unsigned threads;
+    std::size_t memory_mb;
+    std::string spill_dir;
+    std::size_t hash_mb;
+    bool canonical;
+    double progress;
+    bool counters;
+    std::optional<std::string> trace;
 };
 
 std::optional<PerftArgs> parse_args(int argc, char **argv) {
     po::options_description desc("Allowed Options");
     desc.add_options()
-        ("depth", po::value<int>()->required(), "Maximum depth to search")
-        ("fen", po::value<std::string>()->required(), "FEN string of the base position")
+        ("depth", po::value<int>(), "Maximum depth to search")
+        ("fen", po::value<std::string>(), "FEN string of the base position")
         ("moves", po::value<std::vector<std::string>>()->multitoken(), 
             "space-separated list of moves from the base position to the position "
             "to be evaluated, where each move is formatted as $source$target$promotion, "
             "e.g. e2e4 or a7b8Q"
-        );
+        )
+        ("strategy", po::value<std::string>()->default_value("legal"),
+            "move generation strategy, either \"legal\" or \"pseudo\" (pseudo-legal "
+            "generation with a legality check before each move is made)"
+        )
+        ("checkpoint", po::value<std::string>(),
+            "file to record finished subtree counts in as the run goes")
+        ("checkpoint-depth", po::value<int>()->default_value(1),
+            "record the counts of every subtree up to this many plies below the root")
+        ("resume", "skip the subtrees already counted in the --checkpoint file")
+        ("processes", po::value<unsigned>()->default_value(0),
+            "split the work between this many worker processes, 0 runs everything in this one")
+        ("split-depth", po::value<int>()->default_value(2),
+            "plies below the root to split the tree into work units at with --processes")
+        ("stats", "also count captures, en-passants, castles, promotions, checks, "
+            "discovered checks, double checks and checkmates at every depth")
+        ("unique", "count the distinct positions at depth rather than the paths to them")
+        ("threads", po::value<unsigned>()->default_value(std::thread::hardware_concurrency()),
+            "threads to use with --unique")
+        ("memory-mb", po::value<std::size_t>()->default_value(1024),
+            "memory for --unique to hold keys in before spilling them to disk")
+        ("spill-dir", po::value<std::string>(),
+            "directory for --unique to spill keys to, defaults to the temp directory")
+        ("hash-mb", po::value<std::size_t>()->default_value(0),
+            "memory for caching subtree counts in, 0 turns the cache off")
+        ("canonical", "key the --hash-mb cache so a position and its colour-flipped mirror "
+            "share an entry")
+        ("progress", po::value<double>()->default_value(0),
+            "print the node count, speed and estimated time left to stderr every this many "
+            "seconds, 0 turns it off")
+        ("counters", "report hardware performance counters (cycles, instructions, branch and "
+            "cache misses) for the run")
+        ("trace", po::value<std::string>(),
+            "write a timeline of each thread's work to this file, as Chrome trace-event JSON")
+        ("worker", "run as a worker for a coordinating fenrir_perft, reading work units "
+            "from stdin");
     po::positional_options_description positional;
     positional.add("depth", 1)
               .add("fen", 1)
@@ -48,15 +111,60 @@ std::optional<PerftArgs> parse_args(int argc, char **argv) {
         );
         po::notify(vm);
 
-        const int depth { vm["depth"].as<int>() };
-        const std::string fen { vm["fen"].as<std::string>() };
+        const bool worker { vm.count("worker") > 0 };
+        // a worker gets its positions from the coordinator
+        if (!worker && (!vm.count("depth") || !vm.count("fen"))) {
+            std::cerr << desc << "\n";
+            return std::nullopt;
+        }
+        const int depth { worker ? 0 : vm["depth"].as<int>() };
+        const std::string fen { worker ? "" : vm["fen"].as<std::string>() };
         std::vector<std::string> moves;
 
         if (vm.count("moves")) {
             moves = vm["moves"].as<std::vector<std::string>>();
         }
 
-        return PerftArgs { depth, fen, moves };
+        const std::string strategy { vm["strategy"].as<std::string>() };
+        const auto mode { parse_gen_mode(strategy) };
+        if (!mode.has_value()) {
+            std::cerr << "Error: unknown strategy \"" << strategy << "\"\n";
+            return std::nullopt;
+        }
+
+        std::optional<std::string> checkpoint;
+        if (vm.count("checkpoint")) {
+            checkpoint = vm["checkpoint"].as<std::string>();
+        }
+        const bool resume { vm.count("resume") > 0 };
+        if (resume && !checkpoint.has_value()) {
+            std::cerr << "Error: --resume needs a --checkpoint file\n";
+            return std::nullopt;
+        }
+
+        return PerftArgs {
+            depth,
+            fen,
+            moves,
+            *mode,
+            checkpoint,
+            std::max(1, vm["checkpoint-depth"].as<int>()),
+            resume,
+            worker,
+            vm["processes"].as<unsigned>(),
+            std::max(1, vm["split-depth"].as<int>()),
+            vm.count("stats") > 0,
+            vm.count("unique") > 0,
+            vm["threads"].as<unsigned>(),
+            vm["memory-mb"].as<std::size_t>(),
+            vm.count("spill-dir") ? vm["spill-dir"].as<std::string>()
+                                  : std::filesystem::temp_directory_path().string(),
+            vm["hash-mb"].as<std::size_t>(),
+            vm.count("canonical") > 0,
+            vm["progress"].as<double>(),
+            vm.count("counters") > 0,
+            vm.count("trace") ? std::optional(vm["trace"].as<std::string>()) : std::nullopt
+        };
     } catch (const std::exception &e) {
         std::cerr << desc << "\n";
         return std::nullopt;
@@ -66,72 +174,252 @@ std::optional<PerftArgs> parse_args(int argc, char **argv) {
     }
 }
 
-static std::uint64_t perft(Board &board, const AttackTable &at, const int depth) {
-    if (depth == 0) {
-        return 1ul;
+// How a subtree gets counted, shared by every subtree in the run
+struct CountOptions {
+    GenMode mode;
+    PerftTable *table;
+    bool canonical;
+    PerftProgress *progress;
+};
+
+// perft() through the cache if there is one
+static std::uint64_t count_subtree(Board &board, const AttackTable &at, const int depth,
+                                   const CountOptions &options) {
+    return options.table
+        ? perft(board, at, depth, *options.table, options.canonical, options.mode,
+                options.progress)
+        : perft(board, at, depth, options.mode, options.progress);
+}
+
+// Same as perft() but every subtree up to split_plies below the root has its count recorded
+// in the checkpoint once it's finished, and is skipped if it's already there.
+static std::uint64_t checkpointed_perft(Board &board, const AttackTable &at, const int depth,
+                                        const CountOptions &options, const int split_plies,
+                                        const std::string &key, PerftCheckpoint &checkpoint) {
+    if (const auto done { checkpoint.find(key) }) {
+        return *done;
     }
 
+    std::uint64_t nodes {};
+    if (split_plies == 0 || depth <= 1) {
+        nodes = count_subtree(board, at, depth, options);
+    } else {
+        std::vector<EncodedMove> moves;
+        moves.reserve(256);
+        MoveGen(moves, board, at).gen();
+        for (const auto move : moves) {
+            board.make_move(move);
+            nodes += checkpointed_perft(board, at, depth-1, options, split_plies-1,
+                                        key + " " + move_to_string(move), checkpoint);
+            board.undo_last_move();
+        }
+    }
+    checkpoint.record(key, nodes);
+    return nodes;
+}
+
+static void print_summary(const std::uint64_t total_nodes,
+                          const std::chrono::steady_clock::time_point t0) {
+    const auto t1 { std::chrono::steady_clock::now() };
+    std::cout << "\n" << total_nodes << "\n";
+    const auto ms { std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count() };
+    std::cout << "Took " << ms/1000 << "." << std::setw(3) << std::setfill('0') << ms%1000 << "s\n";
+    // a fully resumed run can take no time at all
+    if (ms > 0) {
+        const double per_ms { static_cast<double>(total_nodes) / ms };
+        std::cout << "Searched " << static_cast<std::uint64_t>(per_ms*1000)
+                  << " nodes per second\n";
+    }
+}
+
+static std::uint64_t run_perft(Board &board, const AttackTable &at, const int depth,
+                               const GenMode mode, PerftCheckpoint *checkpoint, const int checkpoint_depth,
+                               PerftTable *table, const bool canonical,
+                               const double progress_seconds) {
+    const auto t0 { std::chrono::steady_clock::now() };
     std::vector<EncodedMove> moves;
     moves.reserve(256);
     MoveGen(moves, board, at).gen();
-    std::uint64_t nodes {};
-    for (const auto move : moves) {
+
+    PerftProgress progress;
+    std::optional<ProgressReporter> reporter;
+    if (progress_seconds > 0) {
+        const std::chrono::milliseconds interval {
+            static_cast<std::int64_t>(progress_seconds * 1000)
+        };
+        reporter.emplace(std::span(&progress, 1), moves.size(), interval, std::cerr);
+    }
+    const CountOptions options { mode, table, canonical, reporter ? &progress : nullptr };
+
+    std::uint64_t total_nodes {};
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        const EncodedMove move { moves[i] };
+        const trace::Scope scope { "root move", "subtree", "move", i };
         board.make_move(move);
-        nodes += perft(board, at, depth-1);
+        const auto result {
+            checkpoint ? checkpointed_perft(board, at, depth-1, options, checkpoint_depth-1,
+                                            move_to_string(move), *checkpoint)
+                       : count_subtree(board, at, depth-1, options)
+        };
         board.undo_last_move();
+        if (reporter) {
+            progress.publish();
+            reporter->root_move_done(result);
+        }
+        total_nodes += result;
+        std::cout << move_to_string(move) << " " << result << "\n";
     }
-    return nodes;
+    reporter.reset();
+    print_summary(total_nodes, t0);
+    if (table && table->probes()) {
+        std::cout << "Cache hits " << table->hits() << " of " << table->probes() << " probes ("
+                  << std::fixed << std::setprecision(1)
+                  << 100.0 * table->hits() / table->probes() << "%)\n";
+    }
+    return total_nodes;
+}
+
+static void print_stats(const std::vector<PerftStats> &by_ply) {
+    constexpr int width { 12 };
+    std::cout << "\n" << std::setfill(' ') << std::left << std::setw(6) << "depth";
+    for (const auto *heading : { "nodes", "captures", "e.p.", "castles", "promotions",
+                                 "checks", "discovered", "double", "checkmates" }) {
+        std::cout << std::setw(width) << heading;
+    }
+    std::cout << "\n";
+    for (std::size_t ply = 0; ply < by_ply.size(); ++ply) {
+        const auto &s { by_ply[ply] };
+        std::cout << std::setw(6) << ply + 1;
+        for (const auto count : { s.nodes, s.captures, s.en_passants, s.castles, s.promotions,
+                                  s.checks, s.discovered_checks, s.double_checks,
+                                  s.checkmates }) {
+            std::cout << std::setw(width) << count;
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::right;
 }
 
-static void run_perft(Board &board, const AttackTable &at, const int depth) {
+// Same divide output as run_perft, followed by the stats for every depth. Always uses legal
+// generation, the stats need every move to be legal to classify it.
+static std::uint64_t run_perft_stats(Board &board, const AttackTable &at, const int depth) {
     const auto t0 { std::chrono::steady_clock::now() };
     std::vector<EncodedMove> moves;
     moves.reserve(256);
     MoveGen(moves, board, at).gen();
 
-    std::uint64_t total_nodes {};
+    std::vector<PerftStats> by_ply(depth);
     for (const auto move : moves) {
-        // std::cout << move << "\n";
+        const std::uint64_t before { by_ply.back().nodes };
+        count_move_stats(board, at, move, by_ply.front());
         board.make_move(move);
-        const auto result { perft(board, at, depth-1) };
+        perft_stats(board, at, depth-1, std::span(by_ply).subspan(1));
         board.undo_last_move();
-        total_nodes += result;
-        std::cout << move_to_string(move) << " " << result << "\n";
+        std::cout << move_to_string(move) << " " << by_ply.back().nodes - before << "\n";
     }
-    const auto t1 { std::chrono::steady_clock::now() };
-    std::cout << "\n" << total_nodes << "\n";
-    const auto ms { std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count() };
-    std::cout << "Took " << ms/1000 << "." << std::setw(3) << std::setfill('0') << ms%1000 << "s\n";
-    const double per_ms { static_cast<double>(total_nodes) / ms };
-    std::cout << "Searched " << static_cast<int>(per_ms*1000) << " nodes per second\n";
+    print_summary(by_ply.back().nodes, t0);
+    print_stats(by_ply);
+    return by_ply.back().nodes;
 }
 
-int main(int argc, char **argv) {
-    const auto args { parse_args(argc, argv) };
-    if (!args.has_value()) {
-        return 1;
+// Collects every position split_plies below the root as a work unit. Subtrees that end before
+// then are counted here, they're tiny.
+static void collect_units(Board &board, const AttackTable &at, const int depth,
+                          const int split_plies, const std::size_t root_index,
+                          std::vector<WorkUnit> &units, std::uint64_t &local_nodes) {
+    if (split_plies == 0 || depth <= 1) {
+        if (depth <= 1) {
+            local_nodes += perft(board, at, depth);
+        } else {
+            units.push_back(WorkUnit { root_index, board.to_fen(), depth });
+        }
+        return;
+    }
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    MoveGen(moves, board, at).gen();
+    for (const auto move : moves) {
+        board.make_move(move);
+        collect_units(board, at, depth-1, split_plies-1, root_index, units, local_nodes);
+        board.undo_last_move();
+    }
+}
+
+// Same output as run_perft, but the counting is done by worker processes
+static bool run_coordinator(Board &board, const AttackTable &at, const int depth,
+                            const GenMode mode, const unsigned processes, const int split_depth,
+                            const std::string &worker_exe) {
+    const auto t0 { std::chrono::steady_clock::now() };
+    std::vector<EncodedMove> moves;
+    moves.reserve(256);
+    MoveGen(moves, board, at).gen();
+
+    std::vector<WorkUnit> units;
+    std::vector<std::uint64_t> root_nodes(moves.size());
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        board.make_move(moves[i]);
+        collect_units(board, at, depth-1, split_depth-1, i, units, root_nodes[i]);
+        board.undo_last_move();
+    }
+
+    const auto results { run_distributed(units, worker_exe, processes, mode) };
+    if (!results.has_value()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        root_nodes[units[i].root_index] += (*results)[i];
+    }
+
+    std::uint64_t total_nodes {};
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        total_nodes += root_nodes[i];
+        std::cout << move_to_string(moves[i]) << " " << root_nodes[i] << "\n";
+    }
+    print_summary(total_nodes, t0);
+    return true;
+}
+
+// Runs count, which returns the number of nodes it counted, under the hardware counters if
+// they were asked for and prints them afterwards
+template <typename Count>
+static void with_counters(const bool enabled, Count &&count) {
+    if (!enabled) {
+        count();
+        return;
+    }
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cerr << "Hardware counters unavailable (" << counters.error()
+                  << "), running without them\n";
+        count();
+        return;
+    }
+    counters.start();
+    const std::uint64_t nodes { count() };
+    const PerfSample sample { counters.stop() };
+    std::cout << "\n";
+    print_perf_sample(std::cout, sample, nodes);
+}
+
+// argv0 is for finding this binary to start workers with
+static int run(const PerftArgs &args, const char *argv0) {
+    if (args.worker) {
+        return run_worker(args.strategy);
     }
 
     const AttackTable at {};
-    auto board { Board::init(args->fen) };
+    auto board { Board::init(args.fen) };
     if (!board.has_value()) {
         std::cerr << "Error: Invalid fen string\n";
         return 1;
     }
 
     std::vector<std::string_view> input_moves;
-    for (const auto &move_string : args->moves) {
+    for (const auto &move_string : args.moves) {
         const auto moves { utility::split(move_string, ' ') };
         std::copy(moves.begin(), moves.end(), std::back_inserter(input_moves));
     }
 
-    std::vector<EncodedMove> legal_moves;
-    legal_moves.reserve(256);
-
-    const auto is_legal_move = [&](const EncodedMove move) {
-        return std::find(legal_moves.begin(), legal_moves.end(), move) != legal_moves.end();
-    };
-
     for (const auto input_move : input_moves) {
         const auto parsed_move { parse_move_input(input_move, *board) };
         if (!parsed_move.has_value()) {
@@ -139,8 +427,7 @@ int main(int argc, char **argv) {
             return 1;
         }
 
-        MoveGen(legal_moves, *board, at).gen();
-        if (is_legal_move(*parsed_move)) {
+        if (is_legal(*board, at, *parsed_move)) {
             board->make_move(*parsed_move);
         } else {
             std::cerr << "Error: move \"" << input_move << "\" is not a legal move\n";
@@ -148,5 +435,104 @@ int main(int argc, char **argv) {
         }
     }
 
-    run_perft(*board, at, args->depth);
+    if (args.hash_mb > 0 && (args.unique || args.stats || args.processes > 0)) {
+        std::cerr << "Error: --hash-mb can't be combined with --unique, --stats or --processes\n";
+        return 1;
+    }
+    if (args.counters && (args.unique || args.processes > 0)) {
+        std::cerr << "Error: --counters can't be combined with --unique or --processes\n";
+        return 1;
+    }
+    if (args.canonical && args.hash_mb == 0) {
+        std::cerr << "Error: --canonical needs a --hash-mb cache\n";
+        return 1;
+    }
+
+    if (args.unique) {
+        if (args.stats || args.processes > 0 || args.checkpoint.has_value()) {
+            std::cerr << "Error: --unique can't be combined with --stats, --processes or "
+                         "--checkpoint\n";
+            return 1;
+        }
+        const auto t0 { std::chrono::steady_clock::now() };
+        const auto result {
+            count_unique_positions(*board, at, args.depth, args.threads,
+                                   args.memory_mb * 1024 * 1024, args.spill_dir)
+        };
+        std::cout << result.paths << " paths\n" << result.unique << " unique positions\n";
+        if (result.spilled_runs) {
+            std::cout << "Spilled " << result.spilled_runs << " runs to disk\n";
+        }
+        const auto t1 { std::chrono::steady_clock::now() };
+        const auto ms { std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count() };
+        std::cout << "Took " << ms/1000 << "." << std::setw(3) << std::setfill('0') << ms%1000
+                  << "s\n";
+        return 0;
+    }
+
+    if (args.stats) {
+        if (args.processes > 0 || args.checkpoint.has_value()) {
+            std::cerr << "Error: --stats can't be combined with --processes or --checkpoint\n";
+            return 1;
+        }
+        if (args.depth < 1) {
+            std::cerr << "Error: --stats needs a depth of at least 1\n";
+            return 1;
+        }
+        with_counters(args.counters, [&] { return run_perft_stats(*board, at, args.depth); });
+        return 0;
+    }
+
+    if (args.processes > 0) {
+        if (args.checkpoint.has_value()) {
+            std::cerr << "Error: --checkpoint isn't supported with --processes\n";
+            return 1;
+        }
+        // workers are this same binary
+        std::error_code error;
+        auto exe { std::filesystem::read_symlink("/proc/self/exe", error) };
+        if (error) {
+            exe = argv0;
+        }
+        return run_coordinator(*board, at, args.depth, args.strategy, args.processes,
+                               args.split_depth, exe.string()) ? 0 : 1;
+    }
+
+    std::optional<PerftCheckpoint> checkpoint;
+    if (args.checkpoint.has_value()) {
+        // the checkpoint is only valid for exactly the same run
+        std::string header { "perft " + std::to_string(args.depth) + " " + args.fen };
+        for (const auto input_move : input_moves) {
+            header += " ";
+            header += input_move;
+        }
+        checkpoint = PerftCheckpoint::open(*args.checkpoint, header, args.resume);
+        if (!checkpoint.has_value()) {
+            return 1;
+        }
+        if (args.resume) {
+            std::cerr << "Resuming with " << checkpoint->size() << " finished subtrees\n";
+        }
+    }
+
+    std::optional<PerftTable> table;
+    if (args.hash_mb > 0) {
+        table.emplace(args.hash_mb * 1024 * 1024);
+    }
+
+    with_counters(args.counters, [&] {
+        return run_perft(*board, at, args.depth, args.strategy,
+                         checkpoint ? &*checkpoint : nullptr, args.checkpoint_depth,
+                         table ? &*table : nullptr, args.canonical, args.progress);
+    });
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const auto args { parse_args(argc, argv) };
+    if (!args.has_value()) {
+        return 1;
+    }
+    trace::Output trace_output { args->trace };
+    return trace_output.finish(run(*args, argv[0]));
 }
@@ -0,0 +1,99 @@
+#include "perft_checkpoint.h"
+
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+std::optional<std::unordered_map<std::string, std::uint64_t>> load_checkpoint(
+    std::istream &in, std::string_view header) {
+    std::string line;
+    if (!std::getline(in, line) || line != header) {
+        return std::nullopt;
+    }
+
+    std::unordered_map<std::string, std::uint64_t> done;
+    while (std::getline(in, line)) {
+        // every complete line ends in a newline, without one the line was cut off part way
+        // through the count
+        if (in.eof()) {
+            break;
+        }
+        // "<moves> <nodes>", the node count is always the last field
+        const auto space { line.rfind(' ') };
+        if (space == std::string::npos || space == 0) {
+            continue;
+        }
+        std::uint64_t nodes {};
+        const char *first { line.data() + space + 1 };
+        const char *last { line.data() + line.size() };
+        const auto [end, error] { std::from_chars(first, last, nodes) };
+        if (error != std::errc {} || end != last) {
+            continue;
+        }
+        done[line.substr(0, space)] = nodes;
+    }
+    return done;
+}
+
+std::optional<PerftCheckpoint> PerftCheckpoint::open(const std::string &path,
+                                                     const std::string &header,
+                                                     const bool resume) {
+    PerftCheckpoint checkpoint;
+    if (resume && std::filesystem::exists(path)) {
+        std::ifstream in(path);
+        auto done { load_checkpoint(in, header) };
+        if (!done.has_value()) {
+            std::cerr << "Error: checkpoint \"" << path << "\" is from a different run\n";
+            return std::nullopt;
+        }
+        checkpoint.done = std::move(*done);
+        in.close();
+        // rewrite it rather than append so a torn last line doesn't end up in the middle, and
+        // rewrite it to the side so being killed now doesn't lose the old one
+        const std::string tmp_path { path + ".tmp" };
+        {
+            std::ofstream tmp(tmp_path, std::ios::trunc);
+            tmp << header << "\n";
+            for (const auto &[key, nodes] : checkpoint.done) {
+                tmp << key << " " << nodes << "\n";
+            }
+            if (!tmp.flush()) {
+                std::cerr << "Error: couldn't write checkpoint \"" << tmp_path << "\"\n";
+                return std::nullopt;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tmp_path, path, error);
+        if (error) {
+            std::cerr << "Error: couldn't replace checkpoint \"" << path << "\" with \""
+                      << tmp_path << "\": " << error.message() << "\n";
+            return std::nullopt;
+        }
+        checkpoint.file.open(path, std::ios::app);
+    } else {
+        checkpoint.file.open(path, std::ios::trunc);
+        checkpoint.file << header << "\n";
+    }
+    checkpoint.file.flush();
+
+    if (!checkpoint.file) {
+        std::cerr << "Error: couldn't write checkpoint \"" << path << "\"\n";
+        return std::nullopt;
+    }
+    return checkpoint;
+}
+
+std::optional<std::uint64_t> PerftCheckpoint::find(const std::string &key) const {
+    const auto it { done.find(key) };
+    if (it == done.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void PerftCheckpoint::record(const std::string &key, const std::uint64_t nodes) {
+    done[key] = nodes;
+    file << key << " " << nodes << "\n";
+    file.flush();
+}
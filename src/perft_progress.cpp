@@ -0,0 +1,108 @@
+#include "perft_progress.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+ProgressReporter::ProgressReporter(std::span<const PerftProgress> counters,
+                                   const std::size_t root_moves,
+                                   const std::chrono::milliseconds interval, std::ostream &out)
+    :   counters_(counters),
+        root_moves_(root_moves),
+        interval_(interval),
+        out_(out),
+        start_(std::chrono::steady_clock::now()),
+        last_report_(start_),
+        thread_([this] { run(); })
+{}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::lock_guard lock { mutex_ };
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void ProgressReporter::root_move_done(const std::uint64_t nodes) {
+    const std::uint64_t now_counted { counted() };
+    std::lock_guard lock { mutex_ };
+    ++finished_moves_;
+    finished_nodes_ += nodes;
+    counted_at_finish_ = now_counted;
+}
+
+std::uint64_t ProgressReporter::counted() const {
+    std::uint64_t total {};
+    for (const auto &counter : counters_) {
+        total += counter.published();
+    }
+    return total;
+}
+
+void ProgressReporter::run() {
+    std::unique_lock lock { mutex_ };
+    auto next { start_ + interval_ };
+    while (!wake_.wait_until(lock, next, [this] { return stopping_; })) {
+        const auto now { std::chrono::steady_clock::now() };
+        report(now);
+        next = now + interval_;
+    }
+}
+
+static void print_duration(std::ostream &out, const double seconds) {
+    const std::ios_base::fmtflags flags { out.flags() };
+    const char fill { out.fill() };
+    const std::streamsize precision { out.precision() };
+    const auto whole { static_cast<std::uint64_t>(seconds) };
+    if (whole >= 3600) {
+        out << whole / 3600 << "h" << std::setw(2) << std::setfill('0') << whole / 60 % 60
+            << "m" << std::setw(2) << whole % 60 << "s";
+    } else if (whole >= 60) {
+        out << whole / 60 << "m" << std::setw(2) << std::setfill('0') << whole % 60 << "s";
+    } else {
+        out << std::fixed << std::setprecision(1) << seconds << "s";
+    }
+    out.flags(flags);
+    out.fill(fill);
+    out.precision(precision);
+}
+
+static void print_rate(std::ostream &out, const double per_second) {
+    const std::ios_base::fmtflags flags { out.flags() };
+    const std::streamsize precision { out.precision() };
+    out << std::fixed << std::setprecision(1) << per_second / 1e6 << "M nps";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// called with mutex_ held
+void ProgressReporter::report(const std::chrono::steady_clock::time_point now) {
+    using seconds = std::chrono::duration<double>;
+    const std::uint64_t nodes { counted() };
+    const double elapsed { seconds(now - start_).count() };
+    const double since_last { seconds(now - last_report_).count() };
+
+    out_ << "[";
+    print_duration(out_, elapsed);
+    out_ << "] " << nodes << " nodes, ";
+    print_rate(out_, since_last > 0 ? (nodes - last_counted_) / since_last : 0.0);
+    out_ << " (";
+    print_rate(out_, elapsed > 0 ? nodes / elapsed : 0.0);
+    out_ << " avg), " << finished_moves_ << "/" << root_moves_ << " root moves";
+
+    if (finished_moves_ > 0 && nodes > 0) {
+        const double per_move { static_cast<double>(finished_nodes_) / finished_moves_ };
+        const double in_progress { static_cast<double>(nodes - counted_at_finish_) };
+        const double remaining {
+            std::max(0.0, per_move * (root_moves_ - finished_moves_) - in_progress)
+        };
+        out_ << ", ETA ";
+        print_duration(out_, remaining / (nodes / elapsed));
+    }
+    out_ << std::endl;
+
+    last_counted_ = nodes;
+    last_report_ = now;
+}
@@ -0,0 +1,37 @@
+#include "perft_table.h"
+
+#include "fenrir_assert.h"
+
+#include <bit>
+
+PerftTable::PerftTable(const std::size_t bytes) {
+    const std::size_t wanted { bytes / sizeof(Bucket) };
+    const std::size_t count { wanted ? std::bit_floor(wanted) : 1 };
+    buckets_.resize(count);
+    mask_ = count - 1;
+}
+
+std::optional<std::uint64_t> PerftTable::probe(const std::uint64_t key, const int depth) {
+    ++probes_;
+    const Bucket &b { bucket(key) };
+    for (const Entry &entry : { b.deepest, b.recent }) {
+        if (entry.key == key && entry.depth() == depth) {
+            ++hits_;
+            return entry.nodes();
+        }
+    }
+    return std::nullopt;
+}
+
+void PerftTable::store(const std::uint64_t key, const int depth, const std::uint64_t nodes) {
+    BOOST_ASSERT(depth > 0 && depth < 256);
+    BOOST_ASSERT(nodes < (1ul << 56));
+    Bucket &b { bucket(key) };
+    const Entry entry { key, (nodes << 8) | static_cast<std::uint64_t>(depth) };
+    // a deeper subtree saves more work on a hit, so it gets the slot that sticks around
+    if (depth >= b.deepest.depth()) {
+        b.deepest = entry;
+    } else {
+        b.recent = entry;
+    }
+}
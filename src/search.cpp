@@ -0,0 +1,777 @@
+#include "search.h"
+
+#include "eval.h"
+#include "move_gen.h"
+#include "move_ordering.h"
+#include "see.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+namespace score {
+
+std::string to_string(const int score) {
+    std::string s;
+    if (is_mate(score)) {
+        // plies to mate, rounded up to whole moves
+        const int plies { MATE - std::abs(score) };
+        const int moves { (plies + 1) / 2 };
+        s = "mate ";
+        s += std::to_string(score > 0 ? moves : -moves);
+    } else {
+        s = "cp ";
+        s += std::to_string(score);
+    }
+    return s;
+}
+
+} // namespace score
+
+SearchStats& SearchStats::operator+=(const SearchStats &other) {
+    qnodes += other.qnodes;
+    see_pruned += other.see_pruned;
+    cutoffs += other.cutoffs;
+    first_move_cutoffs += other.first_move_cutoffs;
+    null_cutoffs += other.null_cutoffs;
+    reductions += other.reductions;
+    lmr_re_searches += other.lmr_re_searches;
+    late_moves_pruned += other.late_moves_pruned;
+    pvs_re_searches += other.pvs_re_searches;
+    aspiration_fail_lows += other.aspiration_fail_lows;
+    aspiration_fail_highs += other.aspiration_fail_highs;
+    return *this;
+}
+
+double SearchStats::first_move_cutoff_rate() const {
+    return cutoffs ? static_cast<double>(first_move_cutoffs) / static_cast<double>(cutoffs) : 0.0;
+}
+
+std::uint64_t IterationInfo::nps() const {
+    const auto ms { elapsed.count() };
+    return ms > 0 ? nodes * 1000 / static_cast<std::uint64_t>(ms) : 0;
+}
+
+// how many nodes go by between checks of the clock
+static constexpr std::uint64_t CHECK_EVERY { 2048 };
+
+// Mate scores are stored as distance to mate from the node rather than from the root, so
+// they're still right when the node turns up at a different ply
+static int score_to_tt(const int score, const int ply) {
+    if (score >= score::MATE - score::MAX_PLY) {
+        return score + ply;
+    }
+    if (score <= -(score::MATE - score::MAX_PLY)) {
+        return score - ply;
+    }
+    return score;
+}
+
+static int score_from_tt(const int score, const int ply) {
+    if (score >= score::MATE - score::MAX_PLY) {
+        return score - ply;
+    }
+    if (score <= -(score::MATE - score::MAX_PLY)) {
+        return score + ply;
+    }
+    return score;
+}
+
+// From the old Stockfish Lazy SMP, helper n uses entry (n - 1) % 20 and skips a depth when
+// (depth + phase) / size is odd. The helpers end up spread over the next few depths rather than
+// all searching the same one as the main thread.
+static constexpr std::array<int, 20> SKIP_SIZE {
+    1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4
+};
+static constexpr std::array<int, 20> SKIP_PHASE {
+    0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7
+};
+
+// ABDADA only defers moves this close to the root, deeper in the tree a subtree's too small
+// to be worth it
+static constexpr int DEFER_DEPTH { 3 };
+static constexpr std::size_t SEARCHING_SIZE { 1u << 15 };
+
+// Null move pruning: pass and search the rest to a reduced depth with a zero window around
+// beta, if the side to move still fails high it's not worth searching properly. The
+// reduction grows with the depth. From NULL_MOVE_VERIFY_DEPTH a cutoff is only trusted once
+// a reduced search without null moves agrees, in case it was zugzwang.
+static constexpr int NULL_MOVE_DEPTH { 3 };
+static constexpr int NULL_MOVE_VERIFY_DEPTH { 10 };
+
+static int null_move_reduction(const int depth) {
+    return 3 + depth / 6;
+}
+
+// Each iteration from ASPIRATION_DEPTH starts with a window of ASPIRATION_WINDOW either side of
+// the last iteration's score. A fail moves the window's edge past the score it failed with, and
+// after a fail low beta comes down to the middle of the old window. The margin grows by half
+// each time. The bench positions' scores move less than 110 between iterations 9 times out of
+// 10, and windows much smaller than this fail often enough to cost more than they save.
+static constexpr int ASPIRATION_DEPTH { 4 };
+static constexpr int ASPIRATION_WINDOW { 150 };
+
+// Late move reductions: quiet moves from the LMR_MOVE'th on are searched to a reduced depth
+// with a zero window first, and only searched again in full if they beat alpha. The
+// reduction grows with the log of both the depth and the move number.
+static constexpr int LMR_DEPTH { 3 };
+static constexpr int LMR_MOVE { 4 };
+
+static const auto LMR_TABLE { [] {
+    std::array<std::array<int, 64>, 64> table {};
+    for (std::size_t depth = 1; depth < table.size(); ++depth) {
+        for (std::size_t move = 1; move < table[depth].size(); ++move) {
+            table[depth][move] = static_cast<int>(
+                0.75 + std::log(static_cast<double>(depth)) *
+                       std::log(static_cast<double>(move)) / 2.25
+            );
+        }
+    }
+    return table;
+}() };
+
+// Less for a move with a good history or that gives check, more for a bad history, always
+// leaving at least one ply
+static int late_move_reduction(const int depth, const int move_number, const int history,
+                               const bool gives_check) {
+    int reduction { LMR_TABLE[std::min(depth, 63)][std::min(move_number, 63)] };
+    reduction -= history / (MoveOrdering::MAX_HISTORY / 2);
+    reduction -= gives_check;
+    return std::clamp(reduction, 0, depth - 2);
+}
+
+// Late move pruning: up to LMP_DEPTH, quiet moves past the first few that don't give check aren't
+// searched at all
+static constexpr int LMP_DEPTH { 3 };
+
+static int late_move_count(const int depth) {
+    return 3 + depth * depth;
+}
+
+// Whether the side to move has anything but pawns. Without it passing is often the best move
+// there is, so null move pruning would be wrong.
+static bool has_non_pawn_material(const Board &board) {
+    const Bitboard &bb { board.bitboard() };
+    const Colour colour { board.turn_colour() };
+    return bb.colour_mask(colour) & ~bb.colour_piece_mask(colour, PAWN) &
+           ~bb.colour_piece_mask(colour, KING);
+}
+
+std::optional<ParallelMode> parse_parallel_mode(const std::string_view name) {
+    if (name == "lazy") {
+        return ParallelMode::LAZY_SMP;
+    }
+    if (name == "abdada") {
+        return ParallelMode::ABDADA;
+    }
+    return std::nullopt;
+}
+
+std::string_view parallel_mode_name(const ParallelMode mode) {
+    return mode == ParallelMode::LAZY_SMP ? "lazy" : "abdada";
+}
+
+class Search::Worker {
+public:
+    Worker(Search &search, const unsigned index);
+
+    // Iterative deepening until it's told to stop, runs out of depth or finds a mate. Only the
+    // main worker applies the node and time limits and calls on_iteration.
+    void run(Board &board, const IterationCallback &on_iteration);
+
+    // the deepest iteration that finished, the counts are only this worker's
+    SearchResult result { std::nullopt, 0, 0, 0, {}, {} };
+
+private:
+    bool is_main() const { return index == 0; }
+    bool skip_depth(const int depth) const;
+
+    // Calls search_move on each move from picker until it returns true. With ABDADA a move
+    // that another thread is already searching is skipped and only searched once the rest are
+    // done, the first move never is, it's needed to get a bound before anything else.
+    template <typename SearchMove>
+    void search_moves(const Board &board, MovePicker &picker, const int depth, const int ply,
+                      SearchMove &&search_move);
+    std::atomic<std::uint64_t>& searching_slot(const std::uint64_t move_hash) {
+        return search.searching[move_hash & (SEARCHING_SIZE - 1)];
+    }
+
+    // fail soft, a score outside the window is a bound on the real one
+    int search_root(Board &board, const int depth, int alpha, const int beta);
+    int negamax(Board &board, int depth, const int ply, int alpha, const int beta);
+    // captures and promotions only, until the position's quiet
+    int quiesce(Board &board, const int ply, int alpha, const int beta);
+    // checks the limits every so often, once it's returned true it keeps returning true
+    bool out_of_time();
+    // adds the nodes since the last time to the shared count
+    void publish_nodes();
+    // continues line with the stored best moves where the search cut it short on a table hit
+    void extend_pv(Board &board, std::vector<EncodedMove> &line, const int depth);
+
+    Search &search;
+    const unsigned index;
+
+    std::uint64_t nodes {};
+    std::uint64_t published {};
+    std::uint64_t next_check {};
+    bool can_stop {};
+    bool stopped {};
+
+    // kept between iterations so the best move can be moved to the front
+    std::vector<EncodedMove> root_moves;
+    std::vector<int> root_scores;
+    // per ply, so nothing's allocated during the search
+    std::vector<std::vector<EncodedMove>> moves;
+    std::vector<std::vector<int>> scores;
+    std::vector<std::vector<EncodedMove>> deferred;
+    std::vector<std::vector<EncodedMove>> quiets_tried;
+    // the move being searched at each ply, for the countermove table. std::nullopt for a null
+    // move, so there's never two in a row.
+    std::vector<std::optional<EncodedMove>> played;
+    // no null moves while verifying a null move cutoff
+    bool verifying {};
+    MoveOrdering ordering;
+    // the principal variation from each ply, the root's is the whole line
+    std::vector<std::vector<EncodedMove>> pv;
+};
+
+Search::Worker::Worker(Search &search, const unsigned index) :
+    search(search),
+    index(index),
+    moves(score::MAX_PLY),
+    scores(score::MAX_PLY),
+    deferred(score::MAX_PLY),
+    quiets_tried(score::MAX_PLY),
+    played(score::MAX_PLY),
+    ordering(score::MAX_PLY),
+    pv(score::MAX_PLY + 1)
+{
+    for (std::size_t ply = 0; ply < static_cast<std::size_t>(score::MAX_PLY); ++ply) {
+        moves[ply].reserve(256);
+        scores[ply].reserve(256);
+        deferred[ply].reserve(256);
+        quiets_tried[ply].reserve(256);
+    }
+}
+
+template <typename SearchMove>
+void Search::Worker::search_moves(const Board &board, MovePicker &picker, const int depth,
+                                  const int ply, SearchMove &&search_move) {
+    const bool defer {
+        search.mode == ParallelMode::ABDADA && search.workers.size() > 1 && depth >= DEFER_DEPTH
+    };
+    if (!defer) {
+        while (const auto move = picker.next()) {
+            if (search_move(*move)) {
+                return;
+            }
+        }
+        return;
+    }
+
+    auto &later { deferred[ply] };
+    later.clear();
+    bool first { true };
+    while (const auto next = picker.next()) {
+        const EncodedMove move { *next };
+        // | 1 so it's never 0, which marks a free slot
+        const std::uint64_t move_hash {
+            (board.key() ^ (pack_move(move) * 0x9E3779B97F4A7C15)) | 1
+        };
+        auto &slot { searching_slot(move_hash) };
+        if (!first && slot.load(std::memory_order_relaxed) == move_hash) {
+            later.push_back(move);
+            continue;
+        }
+        first = false;
+        slot.store(move_hash, std::memory_order_relaxed);
+        const bool done { search_move(move) };
+        // another thread might have taken the slot for something else in the meantime
+        std::uint64_t expected { move_hash };
+        slot.compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+        if (done) {
+            return;
+        }
+    }
+    for (const auto move : later) {
+        if (search_move(move)) {
+            return;
+        }
+    }
+}
+
+bool Search::Worker::skip_depth(const int depth) const {
+    if (is_main() || search.mode != ParallelMode::LAZY_SMP) {
+        return false;
+    }
+    const std::size_t i { (index - 1) % SKIP_SIZE.size() };
+    return (depth + SKIP_PHASE[i]) / SKIP_SIZE[i] % 2 != 0;
+}
+
+void Search::Worker::publish_nodes() {
+    search.total_nodes.fetch_add(nodes - published, std::memory_order_relaxed);
+    published = nodes;
+}
+
+bool Search::Worker::out_of_time() {
+    if (stopped) {
+        return true;
+    }
+    if (nodes < next_check) {
+        return false;
+    }
+    publish_nodes();
+    const SearchLimits &limits { search.limits };
+    const std::uint64_t total { search.total_nodes.load(std::memory_order_relaxed) };
+    next_check = nodes + CHECK_EVERY;
+    if (limits.nodes && total < limits.nodes) {
+        next_check = std::min(next_check, nodes + (limits.nodes - total));
+    }
+    if (!can_stop) {
+        return false;
+    }
+    stopped = search.stop_requested.load(std::memory_order_relaxed) || (is_main() &&
+        !search.pondering.load(std::memory_order_relaxed) && (
+        (limits.nodes && total >= limits.nodes) ||
+        (limits.time.count() && std::chrono::steady_clock::now() - search.start >= limits.time)
+    ));
+    return stopped;
+}
+
+int Search::Worker::negamax(Board &board, int depth, const int ply, int alpha, const int beta) {
+    if (depth <= 0) {
+        return quiesce(board, ply, alpha, beta);
+    }
+    ++nodes;
+    pv[ply].clear();
+    if (out_of_time()) {
+        return 0;
+    }
+
+    if (ply > 0 && (board.quiet_half_moves() >= 100 || board.is_repetition())) {
+        return 0;
+    }
+    if (ply >= score::MAX_PLY - 1) {
+        return eval::evaluate(board);
+    }
+
+    PackedMove hash_move {};
+    if (const auto entry { search.tt.probe(board.key()) }) {
+        hash_move = entry->move;
+        if (entry->depth >= depth) {
+            const int score { score_from_tt(entry->score, ply) };
+            if (entry->bound == Bound::EXACT ||
+                (entry->bound == Bound::LOWER && score >= beta) ||
+                (entry->bound == Bound::UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    const bool in_check { king_in_check(board.bitboard(), search.at, board.turn_colour()) };
+    const std::optional<EncodedMove> previous { played[ply-1] };
+    if (depth >= NULL_MOVE_DEPTH && !in_check && !verifying && previous &&
+        !score::is_mate(beta) && has_non_pawn_material(board) &&
+        eval::evaluate(board) >= beta) {
+        const int reduced { depth - 1 - null_move_reduction(depth) };
+        played[ply] = std::nullopt;
+        board.make_null_move();
+        int score { -negamax(board, reduced, ply+1, -beta, -beta+1) };
+        board.undo_null_move();
+        if (stopped) {
+            return 0;
+        }
+        if (score >= beta) {
+            // a mate found after passing isn't a real one
+            score = score::is_mate(score) ? beta : score;
+            if (depth >= NULL_MOVE_VERIFY_DEPTH) {
+                verifying = true;
+                const int verified { negamax(board, reduced + 1, ply, beta-1, beta) };
+                verifying = false;
+                if (stopped) {
+                    return 0;
+                }
+                if (verified < beta) {
+                    score = -score::INFINITE;
+                }
+            }
+            if (score >= beta) {
+                ++result.stats.null_cutoffs;
+                return score;
+            }
+        }
+    }
+
+    auto &ply_moves { moves[ply] };
+    MoveGen(ply_moves, board, search.at).gen();
+    if (ply_moves.empty()) {
+        return in_check ? -score::MATE + ply : 0;
+    }
+    ordering.score(ply_moves, scores[ply], ply, hash_move, previous);
+    MovePicker picker { ply_moves, scores[ply] };
+    ordering.clear_killers(ply + 1);
+    auto &quiets { quiets_tried[ply] };
+    quiets.clear();
+
+    const int original_alpha { alpha };
+    int best { -score::INFINITE };
+    PackedMove best_move {};
+    int move_number {};
+    search_moves(board, picker, depth, ply, [&](const EncodedMove move) {
+        ++move_number;
+        const bool quiet { is_quiet(move) };
+        played[ply] = move;
+        board.make_move(move);
+        // whether it gives check is only needed for the late quiets that might be pruned or
+        // reduced, late_move_count is never less than LMR_MOVE
+        const bool late { quiet && !in_check && move_number >= LMR_MOVE };
+        const bool gives_check {
+            late && king_in_check(board.bitboard(), search.at, board.turn_colour())
+        };
+        // not a check, and not until a move's been found that doesn't get mated
+        if (late && !gives_check && depth <= LMP_DEPTH && move_number > late_move_count(depth) &&
+            best > -(score::MATE - score::MAX_PLY)) {
+            board.undo_last_move();
+            ++result.stats.late_moves_pruned;
+            return false;
+        }
+        int reduction {};
+        if (late && depth >= LMR_DEPTH) {
+            reduction = late_move_reduction(depth, move_number, ordering.history_score(move),
+                                            gives_check);
+        }
+        // PVS: only the first move gets the full window, the rest just need showing they're no
+        // better than it with a zero window, and are searched again if they turn out to be
+        int score {};
+        if (move_number == 1) {
+            score = -negamax(board, depth-1, ply+1, -beta, -alpha);
+        } else {
+            if (reduction > 0) {
+                ++result.stats.reductions;
+                score = -negamax(board, depth-1-reduction, ply+1, -alpha-1, -alpha);
+                if (score > alpha && !stopped) {
+                    ++result.stats.lmr_re_searches;
+                    score = -negamax(board, depth-1, ply+1, -alpha-1, -alpha);
+                }
+            } else {
+                score = -negamax(board, depth-1, ply+1, -alpha-1, -alpha);
+            }
+            if (score > alpha && score < beta && !stopped) {
+                ++result.stats.pvs_re_searches;
+                score = -negamax(board, depth-1, ply+1, -beta, -alpha);
+            }
+        }
+        board.undo_last_move();
+        if (stopped) {
+            return true;
+        }
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = pack_move(move);
+                pv[ply].clear();
+                pv[ply].push_back(move);
+                pv[ply].insert(pv[ply].end(), pv[ply+1].begin(), pv[ply+1].end());
+            }
+        }
+        if (alpha >= beta) {
+            ++result.stats.cutoffs;
+            result.stats.first_move_cutoffs += move_number == 1;
+            if (is_quiet(move)) {
+                ordering.quiet_cutoff(move, quiets, ply, depth, previous);
+            }
+            return true;
+        }
+        if (quiet) {
+            quiets.push_back(move);
+        }
+        return false;
+    });
+    if (stopped) {
+        return 0;
+    }
+
+    const Bound bound {
+        best >= beta ? Bound::LOWER : best > original_alpha ? Bound::EXACT : Bound::UPPER
+    };
+    search.tt.store(board.key(), best_move, score_to_tt(best, ply), depth, bound);
+    return best;
+}
+
+int Search::Worker::quiesce(Board &board, const int ply, int alpha, const int beta) {
+    ++nodes;
+    ++result.stats.qnodes;
+    pv[ply].clear();
+    if (out_of_time()) {
+        return 0;
+    }
+    if (ply >= score::MAX_PLY - 1) {
+        return eval::evaluate(board);
+    }
+
+    // not in check the side to move can stand pat rather than make a bad capture, in check
+    // every evasion is searched
+    const bool in_check { king_in_check(board.bitboard(), search.at, board.turn_colour()) };
+    int best { -score::INFINITE };
+    if (!in_check) {
+        best = eval::evaluate(board);
+        if (best >= beta) {
+            return best;
+        }
+        alpha = std::max(alpha, best);
+    }
+
+    auto &ply_moves { moves[ply] };
+    MoveGen(ply_moves, board, search.at).gen_captures();
+    if (ply_moves.empty()) {
+        return in_check ? -score::MATE + ply : best;
+    }
+    // the evasions when in check are scored the same way, captures first
+    ordering.score(ply_moves, scores[ply], ply, 0, std::nullopt);
+    MovePicker picker { ply_moves, scores[ply] };
+
+    while (const auto next = picker.next()) {
+        const EncodedMove move { *next };
+        if (!in_check && !see_ge(board, search.at, move, 0)) {
+            ++result.stats.see_pruned;
+            continue;
+        }
+        board.make_move(move);
+        const int score { -quiesce(board, ply+1, -beta, -alpha) };
+        board.undo_last_move();
+        if (stopped) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                pv[ply].clear();
+                pv[ply].push_back(move);
+                pv[ply].insert(pv[ply].end(), pv[ply+1].begin(), pv[ply+1].end());
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void Search::Worker::extend_pv(Board &board, std::vector<EncodedMove> &line, const int depth) {
+    for (const auto move : line) {
+        board.make_move(move);
+    }
+    std::vector<EncodedMove> legal;
+    while (static_cast<int>(line.size()) < depth && !board.is_repetition()) {
+        const auto entry { search.tt.probe(board.key()) };
+        if (!entry.has_value() || !entry->move) {
+            break;
+        }
+        legal.clear();
+        MoveGen(legal, board, search.at).gen();
+        const auto it { std::find_if(legal.begin(), legal.end(), [&](const auto move) {
+            return matches(entry->move, move);
+        }) };
+        if (it == legal.end()) {
+            break;
+        }
+        line.push_back(*it);
+        board.make_move(*it);
+    }
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        board.undo_last_move();
+    }
+}
+
+int Search::Worker::search_root(Board &board, const int depth, int alpha, const int beta) {
+    ++nodes;
+    pv[0].clear();
+    // root_moves is already in the order wanted, the previous best first
+    root_scores.resize(root_moves.size());
+    for (std::size_t i = 0; i < root_scores.size(); ++i) {
+        root_scores[i] = static_cast<int>(root_scores.size() - i);
+    }
+    MovePicker picker { root_moves, root_scores };
+    int best { -score::INFINITE };
+    bool first { true };
+    search_moves(board, picker, depth, 0, [&](const EncodedMove move) {
+        played[0] = move;
+        board.make_move(move);
+        int score {};
+        if (first) {
+            score = -negamax(board, depth-1, 1, -beta, -alpha);
+        } else {
+            score = -negamax(board, depth-1, 1, -alpha-1, -alpha);
+            if (score > alpha && score < beta && !stopped) {
+                ++result.stats.pvs_re_searches;
+                score = -negamax(board, depth-1, 1, -beta, -alpha);
+            }
+        }
+        board.undo_last_move();
+        first = false;
+        if (stopped) {
+            return true;
+        }
+        best = std::max(best, score);
+        if (score > alpha) {
+            alpha = score;
+            pv[0].clear();
+            pv[0].push_back(move);
+            pv[0].insert(pv[0].end(), pv[1].begin(), pv[1].end());
+        }
+        return alpha >= beta;
+    });
+    return stopped ? 0 : best;
+}
+
+void Search::Worker::run(Board &board, const IterationCallback &on_iteration) {
+    nodes = 0;
+    published = 0;
+    next_check = 0;
+    stopped = false;
+    result = SearchResult { std::nullopt, 0, 0, 0, {}, {} };
+    ordering.clear();
+
+    root_moves.clear();
+    MoveGen(root_moves, board, search.at).gen();
+    if (root_moves.empty()) {
+        result.score = king_in_check(board.bitboard(), search.at, board.turn_colour())
+            ? -score::MATE : 0;
+        return;
+    }
+    result.best_move = root_moves.front();
+
+    const SearchLimits &limits { search.limits };
+    const int max_depth {
+        limits.depth > 0 ? std::min(limits.depth, score::MAX_PLY - 1) : score::MAX_PLY - 1
+    };
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        if (skip_depth(depth)) {
+            continue;
+        }
+        const trace::Scope scope { "iteration", "search", "depth",
+                                   static_cast<std::uint64_t>(depth) };
+        // the main thread always finishes its first iteration so there's a move to play
+        can_stop = !is_main() || depth > 1;
+        int delta { ASPIRATION_WINDOW };
+        int alpha { -score::INFINITE };
+        int beta { score::INFINITE };
+        if (depth >= ASPIRATION_DEPTH && !score::is_mate(result.score)) {
+            alpha = std::max(result.score - delta, -score::INFINITE);
+            beta = std::min(result.score + delta, score::INFINITE);
+        }
+        int score {};
+        while (true) {
+            score = search_root(board, depth, alpha, beta);
+            if (stopped) {
+                break;
+            }
+            if (score <= alpha) {
+                ++result.stats.aspiration_fail_lows;
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -score::INFINITE);
+            } else if (score >= beta) {
+                ++result.stats.aspiration_fail_highs;
+                beta = std::min(score + delta, score::INFINITE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+        if (stopped) {
+            break;
+        }
+
+        search.tt.store(board.key(), pack_move(pv[0].front()), score_to_tt(score, 0), depth,
+                        Bound::EXACT);
+        extend_pv(board, pv[0], depth);
+        result.best_move = pv[0].front();
+        result.score = score;
+        result.depth = depth;
+        result.pv = pv[0];
+        // searched first next time, it's the most likely to still be best
+        const auto best { std::find(root_moves.begin(), root_moves.end(), pv[0].front()) };
+        std::rotate(root_moves.begin(), best, best + 1);
+
+        if (is_main() && on_iteration) {
+            publish_nodes();
+            const auto elapsed {
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - search.start)
+            };
+            on_iteration(IterationInfo {
+                depth, score, search.total_nodes.load(std::memory_order_relaxed), elapsed, pv[0],
+                search.tt.hashfull()
+            });
+        }
+        // a mate that's been seen in full won't get any shorter by going deeper
+        if (score::is_mate(score) && score::MATE - std::abs(score) <= depth) {
+            break;
+        }
+    }
+    publish_nodes();
+}
+
+Search::Search(const AttackTable &at, TranspositionTable &tt, const unsigned threads,
+               const ParallelMode mode) :
+    at(at),
+    tt(tt),
+    mode(mode),
+    searching(SEARCHING_SIZE)
+{
+    set_threads(threads);
+}
+
+Search::~Search() = default;
+
+void Search::set_threads(const unsigned threads) {
+    workers.clear();
+    for (unsigned i = 0; i < std::max(threads, 1u); ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+    }
+}
+
+SearchResult Search::run(Board &board, const SearchLimits &search_limits,
+                         const IterationCallback &on_iteration) {
+    limits = search_limits;
+    start = std::chrono::steady_clock::now();
+    total_nodes.store(0, std::memory_order_relaxed);
+    stop_requested.store(false, std::memory_order_relaxed);
+    tt.new_search();
+
+    {
+        std::vector<std::jthread> helpers;
+        for (std::size_t i = 1; i < workers.size(); ++i) {
+            helpers.emplace_back([this, i, helper_board = board]() mutable {
+                std::string name { "search " };
+                name += std::to_string(i);
+                trace::set_thread_name(std::move(name));
+                workers[i]->run(helper_board, {});
+            });
+        }
+        workers[0]->run(board, on_iteration);
+        // the helpers carry on until the main thread's done
+        stop();
+    }
+
+    const Worker *best { workers[0].get() };
+    for (const auto &worker : workers) {
+        const SearchResult &r { worker->result };
+        if (r.depth > best->result.depth ||
+            (r.depth == best->result.depth && r.score > best->result.score)) {
+            best = worker.get();
+        }
+    }
+    SearchResult result { best->result };
+    result.nodes = total_nodes.load(std::memory_order_relaxed);
+    result.stats = {};
+    for (const auto &worker : workers) {
+        result.stats += worker->result.stats;
+    }
+    return result;
+}
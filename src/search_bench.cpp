@@ -0,0 +1,127 @@
+#include "search_bench.h"
+
+#include "board.h"
+#include "search.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// the standard perft positions, a mix of openings, middlegames and endgames
+constexpr std::array<std::string_view, 6> POSITIONS {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+struct BenchRun {
+    std::chrono::microseconds time;
+    std::uint64_t nodes;
+    // the nodes of each position's last two iterations, summed
+    std::uint64_t last_iteration_nodes;
+    std::uint64_t previous_iteration_nodes;
+
+    // effective branching factor, how many times more nodes the last iteration took than the
+    // one before it
+    double ebf() const {
+        return previous_iteration_nodes ? static_cast<double>(last_iteration_nodes) /
+                                          static_cast<double>(previous_iteration_nodes)
+                                        : 0.0;
+    }
+
+    std::uint64_t nps() const {
+        return time.count() ? nodes * 1'000'000 / static_cast<std::uint64_t>(time.count()) : 0;
+    }
+};
+
+BenchRun bench_threads(const AttackTable &at, TranspositionTable &tt, const ParallelMode mode,
+                       const unsigned threads, const int depth) {
+    Search search { at, tt, threads, mode };
+    BenchRun total { std::chrono::microseconds(0), 0, 0, 0 };
+    std::vector<std::uint64_t> iteration_nodes;
+    for (const auto fen : POSITIONS) {
+        auto board { *Board::init(fen) };
+        tt.clear(std::thread::hardware_concurrency());
+        iteration_nodes.clear();
+        const auto start { std::chrono::steady_clock::now() };
+        const auto result {
+            search.run(board, SearchLimits { depth, 0, {} }, [&](const IterationInfo &info) {
+                iteration_nodes.push_back(info.nodes);
+            })
+        };
+        total.time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        total.nodes += result.nodes;
+        // the counts are running totals. A position that finished early on a mate is left out.
+        const std::size_t n { iteration_nodes.size() };
+        if (n >= 3 && result.depth == depth) {
+            total.last_iteration_nodes += iteration_nodes[n-1] - iteration_nodes[n-2];
+            total.previous_iteration_nodes += iteration_nodes[n-2] - iteration_nodes[n-3];
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+std::vector<unsigned> doubling_thread_counts(const unsigned max_threads) {
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n <= max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    if (counts.empty() || counts.back() != max_threads) {
+        counts.push_back(std::max(max_threads, 1u));
+    }
+    return counts;
+}
+
+void search_bench(std::ostream &out, const AttackTable &at, const SearchBenchOptions &options) {
+    TranspositionTable tt { options.hash_mb, std::thread::hardware_concurrency() };
+    const std::ios_base::fmtflags flags { out.flags() };
+    const std::streamsize precision { out.precision() };
+    out << POSITIONS.size() << " positions to depth " << options.depth << ", "
+        << options.hash_mb << "MB hash\n\n";
+    out << std::left << std::setw(8) << "mode" << std::setw(9) << "threads" << std::right
+        << std::setw(12) << "time (ms)" << std::setw(10) << "speedup"
+        << std::setw(14) << "nodes" << std::setw(14) << "nps"
+        << std::setw(12) << "nps scale" << std::setw(8) << "ebf" << "\n";
+
+    std::optional<BenchRun> first;
+    for (const ParallelMode mode : options.modes) {
+        for (const unsigned threads : options.threads) {
+            const BenchRun run { bench_threads(at, tt, mode, threads, options.depth) };
+            if (!first.has_value()) {
+                first = run;
+            }
+            const double speedup {
+                run.time.count() ? static_cast<double>(first->time.count()) / run.time.count()
+                                 : 0.0
+            };
+            const double nps_scale {
+                first->nps() ? static_cast<double>(run.nps()) / first->nps() : 0.0
+            };
+            out << std::left << std::setw(8) << parallel_mode_name(mode)
+                << std::setw(9) << threads << std::right
+                << std::setw(12) << run.time.count() / 1000
+                << std::fixed << std::setprecision(2)
+                << std::setw(10) << speedup
+                << std::setw(14) << run.nodes << std::setw(14) << run.nps()
+                << std::setw(12) << nps_scale << std::setw(8) << run.ebf() << "\n";
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,123 @@
+#include "see.h"
+
+#include "attack_table.h"
+#include "board.h"
+#include "colour_traits.h"
+#include "eval.h"
+#include "move_types.h"
+#include "types.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+// Every piece of either colour attacking square through occupied
+std::uint64_t attackers_of(const Bitboard &bb, const AttackTable &at, const Square square,
+                           const std::uint64_t occupied) {
+    const std::uint64_t queens { bb.piece_mask(QUEEN) };
+    const std::uint64_t mask { from_square(square) };
+    // a pawn attacks the square if the square "attacks" it as an enemy pawn would. Not through
+    // the pawn attack table, that has nothing for the first and last ranks.
+    return (ColourTraits<BLACK>::pawn_attacks(mask) & bb.colour_piece_mask(WHITE, PAWN))
+         | (ColourTraits<WHITE>::pawn_attacks(mask) & bb.colour_piece_mask(BLACK, PAWN))
+         | (at.attacks(square, KNIGHT, WHITE, occupied) & bb.piece_mask(KNIGHT))
+         | (at.attacks(square, BISHOP, WHITE, occupied) & (bb.piece_mask(BISHOP) | queens))
+         | (at.attacks(square, ROOK, WHITE, occupied) & (bb.piece_mask(ROOK) | queens))
+         | (at.attacks(square, KING, WHITE, occupied) & bb.piece_mask(KING));
+}
+
+// The most pieces that can attack one square, so the longest an exchange can go on
+constexpr std::size_t MAX_EXCHANGE { 32 };
+
+} // namespace
+
+int see(const Board &board, const AttackTable &at, const EncodedMove move) {
+    const Bitboard &bb { board.bitboard() };
+    const Square dest { static_cast<Square>(move.dest_square) };
+    const auto type { static_cast<MoveType>(move.move_type) };
+    const bool promotion {
+        type == MoveType::MOVE_PROMOTION || type == MoveType::CAPTURE_PROMOTION
+    };
+
+    std::uint64_t occupied {
+        bb.entire_mask() ^ from_square(static_cast<Square>(move.source_square))
+    };
+    if (type == MoveType::EN_PASSANT) {
+        occupied ^= move.colour == WHITE ? ColourTraits<WHITE>::push_back(from_square(dest))
+                                         : ColourTraits<BLACK>::push_back(from_square(dest));
+    }
+
+    // gain[d] is what the side making capture d is up by if the exchange stops after it
+    std::array<int, MAX_EXCHANGE> gain {};
+    gain[0] = move.captured_piece < NUM_PIECES ? eval::PIECE_VALUES[move.captured_piece] : 0;
+    // what's standing on the square, waiting to be captured next
+    int on_square { eval::PIECE_VALUES[move.piece] };
+    if (promotion) {
+        gain[0] += eval::PIECE_VALUES[move.promoted_piece] - eval::PIECE_VALUES[PAWN];
+        on_square = eval::PIECE_VALUES[move.promoted_piece];
+    }
+
+    const std::uint64_t diagonal_sliders { bb.piece_mask(BISHOP) | bb.piece_mask(QUEEN) };
+    const std::uint64_t straight_sliders { bb.piece_mask(ROOK) | bb.piece_mask(QUEEN) };
+    std::uint64_t attackers { attackers_of(bb, at, dest, occupied) & occupied };
+    Colour side { opposite(static_cast<Colour>(move.colour)) };
+    std::size_t d { 0 };
+    while (d + 1 < MAX_EXCHANGE) {
+        const std::uint64_t side_attackers { attackers & bb.colour_mask(side) };
+        if (!side_attackers) {
+            break;
+        }
+        // least valuable attacker first
+        Piece piece { PAWN };
+        std::uint64_t attacker {};
+        for (const auto p : ALL_PIECES) {
+            const std::uint64_t of_type { side_attackers & bb.piece_mask(p) };
+            if (of_type) {
+                piece = p;
+                attacker = of_type & -of_type;
+                break;
+            }
+        }
+
+        occupied ^= attacker;
+        // x-rays, sliders that were behind the attacker now see the square
+        if (piece == PAWN || piece == BISHOP || piece == QUEEN) {
+            attackers |= at.attacks(dest, BISHOP, WHITE, occupied) & diagonal_sliders;
+        }
+        if (piece == ROOK || piece == QUEEN) {
+            attackers |= at.attacks(dest, ROOK, WHITE, occupied) & straight_sliders;
+        }
+        attackers &= occupied;
+
+        // the king can only take if nothing can take it back
+        if (piece == KING && (attackers & bb.colour_mask(opposite(side)))) {
+            break;
+        }
+        ++d;
+        gain[d] = on_square - gain[d-1];
+        on_square = eval::PIECE_VALUES[piece];
+        side = opposite(side);
+    }
+
+    // each side can stop capturing whenever carrying on would lose it material
+    while (d > 0) {
+        gain[d-1] = -std::max(-gain[d-1], gain[d]);
+        --d;
+    }
+    return gain[0];
+}
+
+bool see_ge(const Board &board, const AttackTable &at, const EncodedMove move,
+            const int threshold) {
+    // can't lose anything if nothing's defending it
+    const int best_case {
+        (move.captured_piece < NUM_PIECES ? eval::PIECE_VALUES[move.captured_piece] : 0) +
+        (move.promoted_piece < NUM_PIECES
+            ? eval::PIECE_VALUES[move.promoted_piece] - eval::PIECE_VALUES[PAWN] : 0)
+    };
+    if (best_case < threshold) {
+        return false;
+    }
+    return see(board, at, move) >= threshold;
+}
@@ -0,0 +1,246 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+struct Event {
+    const char *name;
+    const char *category;
+    const char *arg_name;
+    std::uint64_t arg;
+    std::uint64_t ns;
+    char phase;
+};
+
+constexpr std::size_t CAPACITY { 1u << 16 };
+
+// Only the owning thread writes to events, written is published after each one
+struct ThreadBuffer {
+    std::array<Event, CAPACITY> events;
+    std::atomic<std::uint64_t> written {};
+    std::uint32_t tid {};
+    std::string name;
+};
+
+struct Registry {
+    std::mutex mutex;
+    // never freed until exit, a thread_local pointer to one can outlive clear()
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<std::int64_t> start_ns {};
+    bool started {};
+};
+
+Registry& registry() {
+    static Registry registry;
+    return registry;
+}
+
+// plain pointer so there's no initialisation guard on every event
+thread_local ThreadBuffer *local_buffer {};
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+ThreadBuffer& thread_buffer() {
+    if (!local_buffer) [[unlikely]] {
+        Registry &r { registry() };
+        std::lock_guard lock { r.mutex };
+        auto buffer { std::make_unique<ThreadBuffer>() };
+        buffer->tid = static_cast<std::uint32_t>(r.buffers.size() + 1);
+        buffer->name = "thread ";
+        buffer->name += std::to_string(buffer->tid);
+        local_buffer = buffer.get();
+        r.buffers.push_back(std::move(buffer));
+    }
+    return *local_buffer;
+}
+
+void write_string(std::ostream &out, const std::string_view s) {
+    out << '"';
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+void enable() {
+    Registry &r { registry() };
+    {
+        std::lock_guard lock { r.mutex };
+        if (!r.started) {
+            r.start_ns.store(now_ns(), std::memory_order_relaxed);
+            r.started = true;
+        }
+    }
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void disable() {
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void clear() {
+    Registry &r { registry() };
+    std::lock_guard lock { r.mutex };
+    for (auto &buffer : r.buffers) {
+        buffer->written.store(0, std::memory_order_relaxed);
+    }
+}
+
+void set_thread_name(std::string name) {
+    if (!enabled()) {
+        return;
+    }
+    ThreadBuffer &buffer { thread_buffer() };
+    std::lock_guard lock { registry().mutex };
+    buffer.name = std::move(name);
+}
+
+void record(const char *name, const char *category, const char phase,
+            const char *arg_name, const std::uint64_t arg) {
+    ThreadBuffer &buffer { thread_buffer() };
+    const std::int64_t since_start {
+        std::max<std::int64_t>(now_ns() - registry().start_ns.load(std::memory_order_relaxed), 0)
+    };
+    const std::uint64_t n { buffer.written.load(std::memory_order_relaxed) };
+    buffer.events[n % CAPACITY] = Event {
+        name, category, arg_name, arg, static_cast<std::uint64_t>(since_start), phase
+    };
+    buffer.written.store(n + 1, std::memory_order_release);
+}
+
+std::uint64_t dropped() {
+    Registry &r { registry() };
+    std::lock_guard lock { r.mutex };
+    std::uint64_t lost {};
+    for (const auto &buffer : r.buffers) {
+        const std::uint64_t n { buffer->written.load(std::memory_order_acquire) };
+        lost += n > CAPACITY ? n - CAPACITY : 0;
+    }
+    return lost;
+}
+
+void write_json(std::ostream &out) {
+    Registry &r { registry() };
+    std::lock_guard lock { r.mutex };
+    const char fill { out.fill() };
+    out << "{\"traceEvents\":[\n";
+    bool first { true };
+    const auto separator { [&] {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    } };
+    for (const auto &buffer : r.buffers) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":";
+        write_string(out, buffer->name);
+        out << "}}";
+
+        const std::uint64_t n { buffer->written.load(std::memory_order_acquire) };
+        // Scopes on a thread nest, so once the buffer's wrapped an end with no begin still open
+        // before it had its begin overwritten, and is left out rather than ending some other
+        // scope in the viewer
+        std::uint64_t open {};
+        for (std::uint64_t i = n > CAPACITY ? n - CAPACITY : 0; i < n; ++i) {
+            const Event &event { buffer->events[i % CAPACITY] };
+            if (event.phase == 'B') {
+                ++open;
+            } else if (event.phase == 'E') {
+                if (!open) {
+                    continue;
+                }
+                --open;
+            }
+            separator();
+            out << "{\"name\":";
+            write_string(out, event.name);
+            out << ",\"cat\":";
+            write_string(out, event.category);
+            // microseconds, to the nanosecond
+            out << ",\"ph\":\"" << event.phase << "\",\"ts\":" << event.ns / 1000 << "."
+                << std::setw(3) << std::setfill('0') << event.ns % 1000
+                << ",\"pid\":1,\"tid\":" << buffer->tid;
+            if (event.phase == 'i') {
+                out << ",\"s\":\"t\"";
+            }
+            if (event.arg_name) {
+                out << ",\"args\":{";
+                write_string(out, event.arg_name);
+                out << ":" << event.arg << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.fill(fill);
+}
+
+bool write_json(const std::string &path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Error: couldn't open \"" << path << "\" for writing\n";
+        return false;
+    }
+    write_json(out);
+    if (const auto lost { dropped() }) {
+        std::cerr << "Trace buffers overflowed, the oldest " << lost << " events were lost\n";
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "Error: couldn't write the trace to \"" << path << "\"\n";
+        return false;
+    }
+    return true;
+}
+
+Output::Output(std::optional<std::string> path, std::string thread_name) :
+    path(std::move(path))
+{
+    if (this->path.has_value()) {
+        enable();
+        set_thread_name(std::move(thread_name));
+    }
+}
+
+Output::~Output() {
+    finish(0);
+}
+
+int Output::finish(const int exit_code) {
+    if (!path.has_value()) {
+        return exit_code;
+    }
+    const bool written { write_json(*path) };
+    // only ever written once
+    path.reset();
+    return written ? exit_code : 1;
+}
+
+} // namespace trace
@@ -0,0 +1,160 @@
+#include "transposition_table.h"
+
+#include "fenrir_assert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+PackedMove pack_move(const EncodedMove move) {
+    return static_cast<PackedMove>(
+        move.source_square | (move.dest_square << 6) | (move.promoted_piece << 12)
+    );
+}
+
+bool matches(const PackedMove packed, const EncodedMove move) {
+    return packed && packed == pack_move(move);
+}
+
+namespace {
+
+// bits 0-15 the move, 16-31 the score, 32-39 the depth, 40-41 the bound, 42-47 the generation
+constexpr std::uint64_t pack_data(const PackedMove move, const int score, const int depth,
+                                  const Bound bound, const std::uint8_t generation) {
+    return static_cast<std::uint64_t>(move) |
+           static_cast<std::uint64_t>(static_cast<std::uint16_t>(score)) << 16 |
+           static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 32 |
+           static_cast<std::uint64_t>(bound) << 40 |
+           static_cast<std::uint64_t>(generation) << 42;
+}
+
+constexpr PackedMove data_move(const std::uint64_t data) {
+    return static_cast<PackedMove>(data);
+}
+
+constexpr int data_score(const std::uint64_t data) {
+    return static_cast<std::int16_t>(data >> 16);
+}
+
+constexpr int data_depth(const std::uint64_t data) {
+    return static_cast<std::int8_t>(data >> 32);
+}
+
+constexpr Bound data_bound(const std::uint64_t data) {
+    return static_cast<Bound>((data >> 40) & 0x3);
+}
+
+constexpr std::uint8_t data_generation(const std::uint64_t data) {
+    return static_cast<std::uint8_t>((data >> 42) & 0x3F);
+}
+
+std::uint64_t load(const std::uint64_t &word) {
+    return std::atomic_ref(const_cast<std::uint64_t&>(word)).load(std::memory_order_relaxed);
+}
+
+void store(std::uint64_t &word, const std::uint64_t value) {
+    std::atomic_ref(word).store(value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(const std::size_t mb, const unsigned threads) {
+    resize(mb, threads);
+}
+
+void TranspositionTable::resize(const std::size_t mb, const unsigned threads) {
+    mb_ = mb;
+    const std::size_t wanted { mb * 1024 * 1024 / sizeof(Bucket) };
+    count_ = wanted ? std::bit_floor(wanted) : 1;
+    mask_ = count_ - 1;
+    // the old table goes first so both aren't held at once. The new one's left uninitialised,
+    // clear() zeroes it in parallel.
+    buckets_.reset();
+    buckets_.reset(new Bucket[count_]);
+    clear(threads);
+}
+
+void TranspositionTable::clear(const unsigned threads) {
+    const std::size_t n { std::clamp<std::size_t>(threads, 1, count_) };
+    const std::size_t per_thread { (count_ + n - 1) / n };
+    const auto zero { [&](const std::size_t first) {
+        const std::size_t last { std::min(first + per_thread, count_) };
+        std::memset(static_cast<void*>(buckets_.get() + first), 0,
+                    (last - first) * sizeof(Bucket));
+    } };
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < n; ++i) {
+            workers.emplace_back(zero, i * per_thread);
+        }
+        zero(0);
+    }
+    generation_ = 0;
+}
+
+std::optional<TTEntry> TranspositionTable::probe(const std::uint64_t key) const {
+    for (const Slot &slot : bucket(key).slots) {
+        const std::uint64_t data { load(slot.data) };
+        if ((load(slot.check) ^ data) == key && data_bound(data) != Bound::NONE) {
+            return TTEntry {
+                data_move(data), data_score(data), data_depth(data), data_bound(data)
+            };
+        }
+    }
+    return std::nullopt;
+}
+
+void TranspositionTable::store(const std::uint64_t key, PackedMove move, const int score,
+                               const int depth, const Bound bound) {
+    BOOST_ASSERT(score >= INT16_MIN && score <= INT16_MAX);
+    BOOST_ASSERT(depth >= INT8_MIN && depth <= INT8_MAX);
+    Bucket &b { bucket(key) };
+    Slot *replace { &b.slots[0] };
+    int worst { INT_MAX };
+    for (Slot &slot : b.slots) {
+        const std::uint64_t data { load(slot.data) };
+        if (data_bound(data) == Bound::NONE) {
+            replace = &slot;
+            break;
+        }
+        if ((load(slot.check) ^ data) == key) {
+            // a shallower result is still worth keeping over a deeper bound, but a much
+            // deeper exact score is only replaced by another exact score
+            if (data_bound(data) == Bound::EXACT && bound != Bound::EXACT &&
+                data_depth(data) > depth + 3) {
+                return;
+            }
+            if (!move) {
+                move = data_move(data);
+            }
+            replace = &slot;
+            break;
+        }
+        // the shallowest entry goes, older searches' entries count as much shallower
+        const int age { (generation_ - data_generation(data)) & GENERATION_MASK };
+        const int value { data_depth(data) - 8 * age };
+        if (value < worst) {
+            worst = value;
+            replace = &slot;
+        }
+    }
+    const std::uint64_t data { pack_data(move, score, depth, bound, generation_) };
+    ::store(replace->check, key ^ data);
+    ::store(replace->data, data);
+}
+
+int TranspositionTable::hashfull() const {
+    const std::size_t sample { std::min<std::size_t>(1000 / ENTRIES_PER_BUCKET, count_) };
+    int used {};
+    for (std::size_t i = 0; i < sample; ++i) {
+        for (const Slot &slot : buckets_[i].slots) {
+            const std::uint64_t data { load(slot.data) };
+            used += data_bound(data) != Bound::NONE && data_generation(data) == generation_;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * ENTRIES_PER_BUCKET));
+}
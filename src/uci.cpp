@@ -0,0 +1,391 @@
+#include "uci.h"
+
+#include "move_gen.h"
+#include "move_parse.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <utility>
+
+namespace {
+
+// what's kept back from the clock for the move to get to the GUI
+constexpr std::chrono::milliseconds MOVE_OVERHEAD { 50 };
+// how many more moves the clock's assumed to have to last when there's no movestogo
+constexpr int DEFAULT_MOVES_TO_GO { 30 };
+
+// Board keeps 256 moves of history and the search can use up to score::MAX_PLY of them
+constexpr std::size_t GAME_HISTORY { 120 };
+
+constexpr std::size_t MAX_HASH_MB { 65536 };
+constexpr unsigned MAX_THREADS { 256 };
+
+std::optional<std::int64_t> parse_int(const std::string_view s) {
+    std::int64_t value {};
+    const auto [end, ec] { std::from_chars(s.data(), s.data() + s.size(), value) };
+    if (ec != std::errc {} || end != s.data() + s.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace
+
+std::optional<GoCommand> parse_go(const std::string_view args) {
+    GoCommand go {};
+    const auto tokens { utility::split(args, ' ') };
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const std::string_view name { tokens[i] };
+        if (name == "infinite") {
+            go.infinite = true;
+            continue;
+        }
+        if (name == "ponder") {
+            go.ponder = true;
+            continue;
+        }
+        if (i + 1 == tokens.size()) {
+            return std::nullopt;
+        }
+        const auto parsed { parse_int(tokens[++i]) };
+        if (!parsed.has_value()) {
+            return std::nullopt;
+        }
+        // some GUIs send a negative time when the clock's run out
+        const std::int64_t value { std::max<std::int64_t>(*parsed, 0) };
+        const std::chrono::milliseconds ms { value };
+        if (name == "wtime") {
+            go.time[WHITE] = ms;
+        } else if (name == "btime") {
+            go.time[BLACK] = ms;
+        } else if (name == "winc") {
+            go.increment[WHITE] = ms;
+        } else if (name == "binc") {
+            go.increment[BLACK] = ms;
+        } else if (name == "movestogo") {
+            go.moves_to_go = static_cast<int>(std::min<std::int64_t>(value, 1000));
+        } else if (name == "depth") {
+            go.limits.depth = static_cast<int>(std::min<std::int64_t>(value, score::MAX_PLY));
+        } else if (name == "nodes") {
+            go.limits.nodes = static_cast<std::uint64_t>(value);
+        } else if (name == "movetime") {
+            go.limits.time = ms;
+        } else {
+            return std::nullopt;
+        }
+    }
+    return go;
+}
+
+SearchLimits search_limits(const GoCommand &go, const Colour colour) {
+    SearchLimits limits { go.limits };
+    const std::chrono::milliseconds remaining { go.time[colour] };
+    if (limits.time.count() || go.infinite || !remaining.count()) {
+        return limits;
+    }
+    const int moves { go.moves_to_go > 0 ? go.moves_to_go : DEFAULT_MOVES_TO_GO };
+    const std::chrono::milliseconds budget {
+        remaining / moves + go.increment[colour] * 3 / 4
+    };
+    // the search only stops on time once its first iteration's done, so this can't be 0
+    limits.time = std::max(std::min(budget, remaining - MOVE_OVERHEAD),
+                           std::chrono::milliseconds(1));
+    return limits;
+}
+
+Uci::Uci(const AttackTable &at, std::ostream &out, const std::size_t hash_mb,
+         const unsigned threads) :
+    at(at),
+    tt(hash_mb, std::thread::hardware_concurrency()),
+    search(at, tt, threads),
+    board(*Board::init())
+{
+    writer = std::jthread([this, &out] {
+        std::deque<std::string> lines;
+        std::unique_lock lock { output_mutex };
+        while (true) {
+            output_ready.wait(lock, [this] { return !output.empty() || output_done; });
+            if (output.empty()) {
+                return;
+            }
+            lines.swap(output);
+            lock.unlock();
+            for (const auto &line : lines) {
+                out << line << '\n';
+            }
+            out.flush();
+            lines.clear();
+            lock.lock();
+        }
+    });
+}
+
+Uci::~Uci() {
+    stop_search();
+    {
+        const std::lock_guard lock { output_mutex };
+        output_done = true;
+    }
+    output_ready.notify_one();
+    writer.join();
+}
+
+void Uci::run(std::istream &in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!handle(line)) {
+            return;
+        }
+    }
+}
+
+bool Uci::handle(const std::string_view line) {
+    const auto tokens { utility::split(line, ' ') };
+    if (tokens.empty()) {
+        return true;
+    }
+    const std::string_view command { tokens.front() };
+    const std::string_view args {
+        line.substr(static_cast<std::size_t>(command.data() + command.size() - line.data()))
+    };
+
+    if (command == "uci") {
+        uci();
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "setoption") {
+        set_option(args);
+    } else if (command == "ucinewgame") {
+        stop_search();
+        tt.clear(std::thread::hardware_concurrency());
+    } else if (command == "position") {
+        position(args);
+    } else if (command == "go") {
+        go(args);
+    } else if (command == "stop") {
+        // answered once the search has stopped, not waited for here
+        stopping.store(true, std::memory_order_relaxed);
+        search.stop();
+        release_bestmove();
+    } else if (command == "ponderhit") {
+        search.set_pondering(false);
+        if (!infinite) {
+            release_bestmove();
+        }
+    } else if (command == "quit") {
+        stop_search();
+        return false;
+    } else {
+        std::cerr << "Error: unknown command \"" << command << "\"\n";
+    }
+    return true;
+}
+
+void Uci::wait() {
+    if (search_thread.joinable()) {
+        search_thread.join();
+    }
+}
+
+void Uci::uci() {
+    send("id name Fenrir");
+    send("id author the Fenrir authors");
+    std::string hash { "option name Hash type spin default " };
+    hash += std::to_string(tt.size_mb());
+    hash += " min 1 max ";
+    hash += std::to_string(MAX_HASH_MB);
+    send(std::move(hash));
+    std::string threads { "option name Threads type spin default " };
+    threads += std::to_string(search.threads());
+    threads += " min 1 max ";
+    threads += std::to_string(MAX_THREADS);
+    send(std::move(threads));
+    // the GUI only sends go ponder when this is on, there's nothing else to it
+    send("option name Ponder type check default false");
+    send("uciok");
+}
+
+void Uci::set_option(const std::string_view args) {
+    stop_search();
+    // setoption name <name> [value <value>], the name can have spaces in it
+    const auto tokens { utility::split(args, ' ') };
+    if (tokens.empty() || tokens.front() != "name") {
+        std::cerr << "Error: setoption needs a name\n";
+        return;
+    }
+    std::string name;
+    std::size_t i { 1 };
+    for (; i < tokens.size() && tokens[i] != "value"; ++i) {
+        if (!name.empty()) {
+            name += ' ';
+        }
+        name += tokens[i];
+    }
+    const std::optional<std::int64_t> value {
+        i + 1 < tokens.size() ? parse_int(tokens[i+1]) : std::nullopt
+    };
+
+    if (name == "Ponder") {
+        return;
+    }
+    if (name != "Hash" && name != "Threads") {
+        std::cerr << "Error: unknown option \"" << name << "\"\n";
+        return;
+    }
+    if (!value.has_value()) {
+        std::cerr << "Error: option \"" << name << "\" needs a number\n";
+        return;
+    }
+    const std::int64_t n { value.value_or(1) };
+    if (name == "Hash") {
+        tt.resize(static_cast<std::size_t>(std::clamp<std::int64_t>(n, 1, MAX_HASH_MB)),
+                  std::thread::hardware_concurrency());
+    } else {
+        search.set_threads(static_cast<unsigned>(std::clamp<std::int64_t>(n, 1, MAX_THREADS)));
+    }
+}
+
+void Uci::position(const std::string_view args) {
+    stop_search();
+    const auto tokens { utility::split(args, ' ') };
+    std::size_t i { 1 };
+    std::optional<Board> new_board;
+    if (!tokens.empty() && tokens.front() == "startpos") {
+        new_board = Board::init();
+    } else if (!tokens.empty() && tokens.front() == "fen") {
+        std::string fen;
+        for (; i < tokens.size() && tokens[i] != "moves"; ++i) {
+            if (!fen.empty()) {
+                fen += ' ';
+            }
+            fen += tokens[i];
+        }
+        new_board = Board::init(fen);
+        if (!new_board.has_value()) {
+            std::cerr << "Error: Invalid fen string\n";
+            return;
+        }
+    } else {
+        std::cerr << "Error: position needs \"startpos\" or \"fen\"\n";
+        return;
+    }
+
+    board = *new_board;
+    game.clear();
+    if (i == tokens.size() || tokens[i] != "moves") {
+        return;
+    }
+    for (++i; i < tokens.size(); ++i) {
+        const auto move { parse_move_input(tokens[i], board) };
+        if (!move.has_value() || !is_legal(board, at, *move)) {
+            // the moves before it are kept
+            std::cerr << "Error: move \"" << tokens[i] << "\" is not a legal move\n";
+            return;
+        }
+        play(*move);
+    }
+}
+
+void Uci::play(const EncodedMove move) {
+    board.make_move(move);
+    game.push_back(move);
+    if (game.size() < GAME_HISTORY) {
+        return;
+    }
+    // a repetition can't go back past the last capture or pawn move, so only the moves since
+    // then need keeping
+    const std::size_t keep { std::min<std::size_t>(board.quiet_half_moves(), 100) };
+    for (std::size_t i = 0; i < keep; ++i) {
+        board.undo_last_move();
+    }
+    board = *Board::init(board.to_fen());
+    game.erase(game.begin(), game.end() - static_cast<std::ptrdiff_t>(keep));
+    for (const auto kept : game) {
+        board.make_move(kept);
+    }
+}
+
+void Uci::go(const std::string_view args) {
+    stop_search();
+    const auto command { parse_go(args) };
+    if (!command.has_value()) {
+        std::cerr << "Error: invalid go command\n";
+        return;
+    }
+    const SearchLimits limits { search_limits(*command, board.turn_colour()) };
+    infinite = command->infinite;
+    stopping.store(false, std::memory_order_relaxed);
+    hold_bestmove.store(command->infinite || command->ponder);
+    search.set_pondering(command->ponder);
+
+    search_thread = std::jthread([this, limits, position = board]() mutable {
+        const auto result {
+            search.run(position, limits, [this](const IterationInfo &info) {
+                if (stopping.load(std::memory_order_relaxed)) {
+                    search.stop();
+                }
+                std::string line { "info depth " };
+                line += std::to_string(info.depth);
+                line += " score ";
+                line += score::to_string(info.score);
+                line += " nodes ";
+                line += std::to_string(info.nodes);
+                line += " nps ";
+                line += std::to_string(info.nps());
+                line += " time ";
+                line += std::to_string(info.elapsed.count());
+                line += " hashfull ";
+                line += std::to_string(info.hashfull);
+                line += " pv";
+                for (const auto move : info.pv) {
+                    line += ' ';
+                    line += move_to_string(move);
+                }
+                send(std::move(line));
+            })
+        };
+        hold_bestmove.wait(true);
+        std::string line { "bestmove " };
+        if (!result.best_move.has_value()) {
+            line += "0000";
+        } else {
+            line += move_to_string(*result.best_move);
+            if (result.pv.size() > 1) {
+                line += " ponder ";
+                line += move_to_string(result.pv[1]);
+            }
+        }
+        send(std::move(line));
+    });
+}
+
+void Uci::stop_search() {
+    if (!search_thread.joinable()) {
+        return;
+    }
+    stopping.store(true, std::memory_order_relaxed);
+    search.stop();
+    release_bestmove();
+    search_thread.join();
+}
+
+void Uci::release_bestmove() {
+    hold_bestmove.store(false);
+    hold_bestmove.notify_all();
+}
+
+void Uci::send(std::string line) {
+    {
+        const std::lock_guard lock { output_mutex };
+        output.push_back(std::move(line));
+    }
+    output_ready.notify_one();
+}
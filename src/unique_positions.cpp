@@ -0,0 +1,312 @@
+#include "unique_positions.h"
+
+#include "attack_table.h"
+#include "board.h"
+#include "colour_traits.h"
+#include "move_gen.h"
+#include "set_bit_iterator.h"
+#include "trace.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// keys are buffered per thread and handed over this many at a time
+static constexpr std::size_t BATCH_SIZE { 4096 };
+
+SpillingKeySet::SpillingKeySet(const std::size_t memory_budget, std::filesystem::path spill_dir)
+    :   spill_dir(std::move(spill_dir))
+{
+    // power of 2 so probing can mask instead of mod
+    const std::size_t slots { memory_budget / sizeof(std::uint64_t) / NUM_SHARDS };
+    shard_capacity = std::bit_floor(std::max<std::size_t>(slots, 16));
+    for (auto &shard : shards) {
+        shard.table.assign(shard_capacity, 0);
+    }
+}
+
+SpillingKeySet::~SpillingKeySet() {
+    for (auto &shard : shards) {
+        for (const auto &run : shard.runs) {
+            std::error_code error;
+            std::filesystem::remove(run, error);
+        }
+    }
+}
+
+void SpillingKeySet::insert(std::span<std::uint64_t> keys) {
+    const trace::Scope scope { "insert batch", "keys", "keys", keys.size() };
+    // sorting groups the keys by shard
+    std::sort(keys.begin(), keys.end());
+    auto begin { keys.begin() };
+    while (begin != keys.end()) {
+        const std::size_t index { shard_of(*begin) };
+        const auto end {
+            std::find_if(begin, keys.end(), [index](const std::uint64_t key) {
+                return shard_of(key) != index;
+            })
+        };
+        Shard &shard { shards[index] };
+        std::lock_guard lock(shard.mutex);
+        for (auto it = begin; it != end; ++it) {
+            insert_locked(shard, *it);
+            // kept under 3/4 full so probes stay short
+            if (shard.size * 4 >= shard_capacity * 3) {
+                spill(shard, index);
+            }
+        }
+        begin = end;
+    }
+}
+
+void SpillingKeySet::insert_locked(Shard &shard, const std::uint64_t key) {
+    if (key == 0) {
+        shard.has_zero = true;
+        return;
+    }
+    const std::size_t mask { shard_capacity - 1 };
+    // the top bits are the same for the whole shard so probe from the bottom ones
+    for (std::size_t i = key & mask; ; i = (i + 1) & mask) {
+        if (shard.table[i] == key) {
+            return;
+        }
+        if (shard.table[i] == 0) {
+            shard.table[i] = key;
+            ++shard.size;
+            return;
+        }
+    }
+}
+
+std::vector<std::uint64_t> SpillingKeySet::take_sorted(Shard &shard) {
+    std::vector<std::uint64_t> keys;
+    keys.reserve(shard.size + shard.has_zero);
+    if (shard.has_zero) {
+        keys.push_back(0);
+    }
+    for (auto &slot : shard.table) {
+        if (slot) {
+            keys.push_back(slot);
+            slot = 0;
+        }
+    }
+    shard.size = 0;
+    shard.has_zero = false;
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+void SpillingKeySet::spill(Shard &shard, const std::size_t index) {
+    const trace::Scope scope { "spill", "io", "shard", index };
+    const auto keys { take_sorted(shard) };
+    const auto path {
+        spill_dir / ("fenrir_unique_" + std::to_string(getpid()) + "_" + std::to_string(index) +
+                     "_" + std::to_string(shard.runs.size()) + ".bin")
+    };
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(keys.data()),
+               static_cast<std::streamsize>(keys.size() * sizeof(std::uint64_t)));
+    if (!file) {
+        // carrying on would silently give the wrong count
+        std::cerr << "Error: couldn't write spill file \"" << path.string() << "\"\n";
+        std::abort();
+    }
+    shard.runs.push_back(path);
+    ++run_count;
+}
+
+// Reads a run back a chunk at a time
+class RunReader {
+public:
+    explicit RunReader(const std::filesystem::path &path) : file(path, std::ios::binary) {
+        refill();
+    }
+
+    bool done() const { return pos == buffer.size(); }
+    std::uint64_t front() const { return buffer[pos]; }
+    void pop() {
+        if (++pos == buffer.size()) {
+            refill();
+        }
+    }
+private:
+    void refill() {
+        buffer.resize(8192);
+        file.read(reinterpret_cast<char*>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size() * sizeof(std::uint64_t)));
+        buffer.resize(static_cast<std::size_t>(file.gcount()) / sizeof(std::uint64_t));
+        pos = 0;
+    }
+
+    std::ifstream file;
+    std::vector<std::uint64_t> buffer;
+    std::size_t pos {};
+};
+
+std::uint64_t SpillingKeySet::count() {
+    std::uint64_t total {};
+    for (auto &shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        if (shard.runs.empty()) {
+            total += shard.size + shard.has_zero;
+            continue;
+        }
+
+        // everything still in memory gets merged in alongside the runs on disk
+        const auto in_memory { take_sorted(shard) };
+        std::vector<RunReader> readers;
+        readers.reserve(shard.runs.size());
+        for (const auto &run : shard.runs) {
+            readers.emplace_back(run);
+        }
+
+        // (key, source) where source is a reader index, or readers.size() for in_memory
+        using Entry = std::pair<std::uint64_t, std::size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        for (std::size_t i = 0; i < readers.size(); ++i) {
+            if (!readers[i].done()) {
+                heap.emplace(readers[i].front(), i);
+            }
+        }
+        std::size_t memory_pos {};
+        if (!in_memory.empty()) {
+            heap.emplace(in_memory.front(), readers.size());
+        }
+
+        bool any {};
+        std::uint64_t last {};
+        while (!heap.empty()) {
+            const auto [key, source] { heap.top() };
+            heap.pop();
+            if (!any || key != last) {
+                ++total;
+                last = key;
+                any = true;
+            }
+            if (source == readers.size()) {
+                if (++memory_pos < in_memory.size()) {
+                    heap.emplace(in_memory[memory_pos], source);
+                }
+            } else {
+                readers[source].pop();
+                if (!readers[source].done()) {
+                    heap.emplace(readers[source].front(), source);
+                }
+            }
+        }
+    }
+    return total;
+}
+
+// Board::key() includes the en-passant file whenever a pawn is next to the pawn that double
+// pushed, even if taking it would leave the king in check. That's the same position as one
+// where it didn't double push, so the file comes back out unless one of the captures is legal.
+static std::uint64_t position_key(const Board &board, const AttackTable &at) {
+    const std::uint64_t key { board.key() };
+    const auto ep { board.en_passant() };
+    if (!ep.has_value()) {
+        return key;
+    }
+    const Colour us { board.turn_colour() };
+    const std::uint64_t ep_square { from_square(*ep) };
+    const std::uint64_t capturers {
+        (us == WHITE ? ColourTraits<BLACK>::pawn_attacks(ep_square)
+                     : ColourTraits<WHITE>::pawn_attacks(ep_square)) &
+        board.bitboard().colour_piece_mask(us, PAWN)
+    };
+    if (!capturers) {
+        return key;
+    }
+    for (const auto capturer : SetBits(capturers)) {
+        const EncodedMove capture(MoveType::EN_PASSANT, from_mask(capturer), *ep, PAWN, us, PAWN,
+                                  NUM_PIECES);
+        if (is_legal(board, at, capture)) {
+            return key;
+        }
+    }
+    return key ^ zobrist::KEYS.en_passant_file[*ep % 8];
+}
+
+namespace {
+
+struct UniqueWalker {
+    const AttackTable &at;
+    SpillingKeySet &set;
+    std::vector<std::uint64_t> buffer;
+    std::uint64_t paths {};
+
+    // the perft() recursion, but every leaf's key is kept
+    void walk(Board &board, const int depth) {
+        if (depth == 0) {
+            ++paths;
+            buffer.push_back(position_key(board, at));
+            if (buffer.size() == BATCH_SIZE) {
+                flush();
+            }
+            return;
+        }
+        std::vector<EncodedMove> moves;
+        moves.reserve(256);
+        MoveGen(moves, board, at).gen();
+        for (const auto move : moves) {
+            board.make_move(move);
+            walk(board, depth-1);
+            board.undo_last_move();
+        }
+    }
+
+    void flush() {
+        set.insert(buffer);
+        buffer.clear();
+    }
+};
+
+} // namespace
+
+UniqueCount count_unique_positions(const Board &board, const AttackTable &at, const int depth,
+                                   const unsigned threads, const std::size_t memory_budget,
+                                   const std::filesystem::path &spill_dir) {
+    SpillingKeySet set(memory_budget, spill_dir);
+
+    if (depth == 0) {
+        std::uint64_t key { position_key(board, at) };
+        set.insert(std::span(&key, 1));
+        return UniqueCount { 1, set.count(), 0 };
+    }
+
+    std::vector<EncodedMove> root_moves;
+    MoveGen(root_moves, board, at).gen();
+
+    // root moves are handed out one at a time to whichever thread is free
+    std::atomic<std::size_t> next {};
+    std::atomic<std::uint64_t> paths {};
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+            workers.emplace_back([&, i] {
+                trace::set_thread_name("unique worker " + std::to_string(i));
+                Board b { board };
+                UniqueWalker walker { at, set, {}, 0 };
+                walker.buffer.reserve(BATCH_SIZE);
+                for (std::size_t m = next++; m < root_moves.size(); m = next++) {
+                    const trace::Scope scope { "root move", "subtree", "move", m };
+                    b.make_move(root_moves[m]);
+                    walker.walk(b, depth-1);
+                    b.undo_last_move();
+                }
+                walker.flush();
+                paths += walker.paths;
+            });
+        }
+    }
+
+    const std::uint64_t unique { set.count() };
+    return UniqueCount { paths, unique, set.runs() };
+}
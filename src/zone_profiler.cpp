@@ -0,0 +1,86 @@
+#include "zone_profiler.h"
+
+#ifdef FENRIR_PROFILING
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace profiling {
+
+static constexpr std::array<const char*, NUM_ZONES> ZONE_NAMES {
+    "king danger",
+    "pins",
+    "check evasions",
+    "pawn moves",
+    "piece captures",
+    "quiet moves",
+    "king moves",
+    "castling",
+    "make move",
+    "undo move",
+};
+
+// Every thread's totals once it's exited, printed when this is destroyed at exit
+class Report {
+public:
+    void merge(const std::array<ZoneTotals, NUM_ZONES> &totals) {
+        std::lock_guard lock { mutex };
+        for (std::size_t i = 0; i < NUM_ZONES; ++i) {
+            merged[i].cycles += totals[i].cycles;
+            merged[i].calls += totals[i].calls;
+        }
+    }
+
+    ~Report() {
+        std::array<std::size_t, NUM_ZONES> order {};
+        for (std::size_t i = 0; i < NUM_ZONES; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](const std::size_t a, const std::size_t b) {
+            return merged[a].cycles > merged[b].cycles;
+        });
+
+        std::cerr << "\n" << std::left << std::setw(18) << "zone" << std::right
+                  << std::setw(18) << "cycles" << std::setw(14) << "calls"
+                  << std::setw(14) << "cycles/call" << "\n";
+        for (const auto i : order) {
+            if (merged[i].calls == 0) {
+                continue;
+            }
+            std::cerr << std::left << std::setw(18) << ZONE_NAMES[i] << std::right
+                      << std::setw(18) << merged[i].cycles << std::setw(14) << merged[i].calls
+                      << std::setw(14) << std::fixed << std::setprecision(1)
+                      << static_cast<double>(merged[i].cycles) / merged[i].calls << "\n";
+        }
+    }
+private:
+    std::mutex mutex;
+    std::array<ZoneTotals, NUM_ZONES> merged {};
+};
+
+static Report& report() {
+    static Report report;
+    return report;
+}
+
+// Lives in each thread that's used a zone, its destructor runs as the thread exits (before
+// static destructors for the main thread)
+struct ThreadFlush {
+    ~ThreadFlush() {
+        report().merge(thread_totals);
+    }
+};
+
+void register_thread() {
+    // make sure the report is constructed first, so it's destroyed after every flush
+    report();
+    thread_local ThreadFlush flush;
+    static_cast<void>(flush);
+    thread_registered = true;
+}
+
+} // namespace profiling
+
+#endif
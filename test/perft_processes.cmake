@@ -0,0 +1,25 @@
+# Runs fenrir_perft on Kiwipete in one process and split between worker processes, and checks
+# the divide output is the same apart from the timings.
+# cmake -DFENRIR_PERFT=<path to fenrir_perft> -P perft_processes.cmake
+
+set(FEN "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")
+
+execute_process(
+    COMMAND ${FENRIR_PERFT} --fen ${FEN} --depth 3
+    OUTPUT_VARIABLE single
+    RESULT_VARIABLE single_result
+)
+execute_process(
+    COMMAND ${FENRIR_PERFT} --fen ${FEN} --depth 3 --processes 2 --split-depth 2
+    OUTPUT_VARIABLE distributed
+    RESULT_VARIABLE distributed_result
+)
+if(NOT single_result EQUAL 0 OR NOT distributed_result EQUAL 0)
+    message(FATAL_ERROR "fenrir_perft failed: ${single_result} and ${distributed_result}")
+endif()
+
+string(REGEX REPLACE "(Took|Searched) [^\n]*\n" "" single "${single}")
+string(REGEX REPLACE "(Took|Searched) [^\n]*\n" "" distributed "${distributed}")
+if(NOT single STREQUAL distributed)
+    message(FATAL_ERROR "One process:\n${single}\nWith --processes 2:\n${distributed}")
+endif()
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
+#include "attack_table.h"
 #include "board.h"
+#include "move_gen.h"
+#include "move_parse.h"
 
+#include <initializer_list>
 #include <string_view>
+#include <vector>
 
 // Piece placement section of fen are tested elsewhere 
 TEST(TestBoard, TestBoardFromFen) {
@@ -122,3 +127,148 @@ TEST(TestBoard, TestBoardFromFen) {
     ASSERT_TRUE(board.has_value());
     EXPECT_EQ(1, board->fullmove_count_);
 }
+
+TEST(TestBoard, TestBoardToFen) {
+    const std::vector<std::string_view> fens {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/8/6K1/k2pP2R/8/8/8 b - e3 0 50",
+    };
+    for (const auto fen : fens) {
+        EXPECT_EQ(fen, Board::init(fen)->to_fen());
+    }
+
+    auto board { Board::init() };
+    board->make_move(EncodedMove(MoveType::DOUBLE_PAWN_PUSH, E2, E4, PAWN, WHITE, NUM_PIECES,
+                                 NUM_PIECES));
+    EXPECT_EQ("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", board->to_fen());
+}
+
+// The incrementally updated key has to match the key worked out from scratch everywhere in the
+// tree, and undoing has to put it back
+static void check_keys(Board &board, const AttackTable &at, const int depth) {
+    ASSERT_EQ(board.compute_key(), board.key()) << board.to_fen();
+    if (depth == 0) {
+        return;
+    }
+    std::vector<EncodedMove> moves;
+    MoveGen(moves, board, at).gen();
+    for (const auto move : moves) {
+        const std::uint64_t before { board.key() };
+        board.make_move(move);
+        check_keys(board, at, depth-1);
+        board.undo_last_move();
+        ASSERT_EQ(before, board.key());
+    }
+}
+
+TEST(TestBoard, TestBoardKeyIncremental) {
+    const AttackTable at {};
+    const std::vector<std::string_view> fens {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+    for (const auto fen : fens) {
+        Board board { *Board::init(fen) };
+        check_keys(board, at, 3);
+    }
+}
+
+TEST(TestBoard, TestBoardKeyTranspositions) {
+    const AttackTable at {};
+    const auto play { [&](std::initializer_list<std::string_view> moves) {
+        Board board { *Board::init() };
+        for (const auto move : moves) {
+            board.make_move(*parse_move_input(move, board));
+        }
+        return board;
+    } };
+
+    const Board start { *Board::init() };
+    // the clocks aren't part of the key
+    EXPECT_EQ(start.key(), play({ "g1f3", "g8f6", "f3g1", "f6g8" }).key());
+    EXPECT_EQ(play({ "e2e4", "e7e5", "g1f3" }).key(), play({ "g1f3", "e7e5", "e2e4" }).key());
+    // nothing can take en-passant so the double push doesn't change anything
+    EXPECT_EQ(play({ "e2e4", "e7e5" }).key(),
+              play({ "e2e4", "e7e5", "g1f3", "g8f6", "f3g1", "f6g8" }).key());
+    // but here it can
+    const auto ep { play({ "e2e4", "a7a6", "e4e5", "d7d5" }).key() };
+    EXPECT_EQ(Board::init("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3")->key(),
+              ep);
+    EXPECT_NE(Board::init("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3")->key(),
+              ep);
+    EXPECT_NE(start.key(), play({ "g1f3" }).key());
+}
+
+TEST(TestBoard, TestBoardNullMove) {
+    const AttackTable at {};
+    auto board { Board::init("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3") };
+    const std::string fen { board->to_fen() };
+    const std::uint64_t key { board->key() };
+    board->make_null_move();
+    EXPECT_EQ("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3", board->to_fen());
+    EXPECT_EQ(board->compute_key(), board->key());
+    // moves made after the pass are undone as usual
+    check_keys(*board, at, 2);
+    board->undo_null_move();
+    EXPECT_EQ(fen, board->to_fen());
+    EXPECT_EQ(key, board->key());
+
+    // the position before the pass doesn't count as repeated after it, black's triangulation
+    // gets back to it with white to move
+    board = Board::init("4k3/8/8/8/8/8/8/4K3 w - - 10 40");
+    board->make_null_move();
+    for (const auto move : { "e8d7", "e1d1", "d7d8", "d1e1", "d8e8" }) {
+        board->make_move(*parse_move_input(move, *board));
+    }
+    EXPECT_EQ(Board::init("4k3/8/8/8/8/8/8/4K3 w - - 10 40")->key(), board->key());
+    EXPECT_FALSE(board->is_repetition());
+}
+
+TEST(TestBoard, TestBoardMirrored) {
+    const Board start { *Board::init() };
+    EXPECT_EQ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1",
+              start.mirrored().to_fen());
+
+    const Board board {
+        *Board::init("rnbqkbnr/1pp1pppp/p7/3pP3/8/8/PPPP1PPP/RNB1K2R w Kq d6 0 3")
+    };
+    const Board mirror { board.mirrored() };
+    EXPECT_EQ("rnb1k2r/pppp1ppp/8/8/3Pp3/P7/1PP1PPPP/RNBQKBNR b Qk d3 0 3", mirror.to_fen());
+    EXPECT_EQ(board.to_fen(), mirror.mirrored().to_fen());
+    EXPECT_EQ(board.bitboard().mirrored().mirrored(), board.bitboard());
+}
+
+static void check_mirrored_keys(Board &board, const AttackTable &at, const int depth) {
+    const Board mirror { board.mirrored() };
+    ASSERT_EQ(mirror.key(), board.mirrored_key()) << board.to_fen();
+    ASSERT_EQ(board.key(), mirror.mirrored_key()) << board.to_fen();
+    ASSERT_EQ(board.canonical_key(), mirror.canonical_key()) << board.to_fen();
+    if (depth == 0) {
+        return;
+    }
+    std::vector<EncodedMove> moves;
+    MoveGen(moves, board, at).gen();
+    for (const auto move : moves) {
+        board.make_move(move);
+        check_mirrored_keys(board, at, depth-1);
+        board.undo_last_move();
+    }
+}
+
+TEST(TestBoard, TestBoardMirroredKey) {
+    const AttackTable at {};
+    for (const auto fen : {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    }) {
+        Board board { *Board::init(fen) };
+        check_mirrored_keys(board, at, 2);
+    }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "attack_table.h"
+#include "board.h"
+#include "coordinator.h"
+#include "move_gen.h"
+#include "perft.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class TestCoordinator : public testing::Test {
+protected:
+    static const AttackTable at;
+
+    // Kiwipete split one ply below the root, each unit counted depth plies further down
+    static std::vector<WorkUnit> kiwipete_units(const int depth) {
+        auto board { Board::init(
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1") };
+        EXPECT_TRUE(board.has_value());
+        std::vector<EncodedMove> moves;
+        MoveGen(moves, *board, at).gen();
+        std::vector<WorkUnit> units;
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            board->make_move(moves[i]);
+            units.push_back(WorkUnit { i, board->to_fen(), depth });
+            board->undo_last_move();
+        }
+        return units;
+    }
+
+    static std::vector<std::uint64_t> expected_counts(const std::vector<WorkUnit> &units) {
+        std::vector<std::uint64_t> counts;
+        for (const auto &unit : units) {
+            auto board { Board::init(unit.fen) };
+            EXPECT_TRUE(board.has_value());
+            counts.push_back(perft(*board, at, unit.depth));
+        }
+        return counts;
+    }
+
+    // A worker that answers its first unit and exits, leaving the next one it was sent
+    // unanswered
+    static std::string one_unit_worker() {
+        const std::string path { testing::TempDir() + "fenrir_one_unit_worker.sh" };
+        std::ofstream script(path, std::ios::trunc);
+        script << "#!/bin/sh\n"
+               << "IFS= read -r unit\n"
+               << "printf '%s\\n' \"$unit\" | \"" << FENRIR_PERFT << "\" \"$@\"\n";
+        script.close();
+        std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+        return path;
+    }
+};
+
+const AttackTable TestCoordinator::at {};
+
+TEST_F(TestCoordinator, TestMatchesPerft) {
+    const auto units { kiwipete_units(2) };
+    for (const auto mode : { GenMode::LEGAL, GenMode::PSEUDO_LEGAL }) {
+        const auto results { run_distributed(units, FENRIR_PERFT, 2, mode) };
+        ASSERT_TRUE(results.has_value());
+        EXPECT_EQ(expected_counts(units), *results);
+    }
+    EXPECT_EQ(std::vector<std::uint64_t> {}, run_distributed({}, FENRIR_PERFT, 2, GenMode::LEGAL));
+}
+
+TEST_F(TestCoordinator, TestWorkerDies) {
+    // every worker dies after one unit, so nearly every unit goes to a worker that's
+    // replaced before answering and is handed to the next one
+    const auto units { kiwipete_units(1) };
+    const std::string worker { one_unit_worker() };
+    const auto results { run_distributed(units, worker, 2, GenMode::LEGAL) };
+    std::filesystem::remove(worker);
+    ASSERT_TRUE(results.has_value());
+    EXPECT_EQ(expected_counts(units), *results);
+}
+
+TEST_F(TestCoordinator, TestUnitKeepsFailing) {
+    // a worker that never answers anything, the first unit is given up on
+    EXPECT_FALSE(run_distributed(kiwipete_units(1), "/bin/false", 2, GenMode::LEGAL).has_value());
+    EXPECT_FALSE(run_distributed(kiwipete_units(1), "/nonexistent/fenrir_perft", 1,
+                                 GenMode::LEGAL).has_value());
+}
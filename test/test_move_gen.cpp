@@ -7,6 +7,8 @@
 #include "test_helpers.h"
 #include "types.h"
 
+#include <iterator>
+
 class TestMoveGen : public testing::Test {
 protected:
     static const AttackTable at;
@@ -144,4 +146,214 @@ TEST_F(TestMoveGen, TestKingInfo) {
               MaskDisplay(result.king_checking_pieces);
     EXPECT_EQ(mask_from_squares({ C4, E7, D3, E3, E4, E5, E6 }), 
               result.check_intervention_squares) << MaskDisplay(result.check_intervention_squares);
-}
\ No newline at end of file
+}
+
+TEST_F(TestMoveGen, TestForEach) {
+    Board b { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    std::vector<EncodedMove> moves;
+    MoveGen(moves, b, at).gen();
+
+    std::vector<EncodedMove> streamed;
+    EXPECT_TRUE(MoveGen::for_each(b, at, [&streamed](const EncodedMove move) {
+        streamed.push_back(move);
+    }));
+    EXPECT_EQ(48, streamed.size());
+    EXPECT_TRUE(moves == streamed);
+
+    // returning false stops generation after that move
+    std::size_t visited {};
+    EXPECT_FALSE(MoveGen::for_each(b, at, [&visited](const EncodedMove) {
+        return ++visited < 5;
+    }));
+    EXPECT_EQ(5, visited);
+
+    const auto first { first_legal_move(b, at) };
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(moves.front(), *first);
+}
+
+TEST_F(TestMoveGen, TestMateStatus) {
+    Board b { *Board::init() };
+    EXPECT_TRUE(has_legal_move(b, at));
+    EXPECT_EQ(MateStatus::NONE, mate_status(b, at));
+
+    // fool's mate
+    b = *Board::init("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    EXPECT_FALSE(has_legal_move(b, at));
+    EXPECT_FALSE(first_legal_move(b, at).has_value());
+    EXPECT_EQ(MateStatus::CHECKMATE, mate_status(b, at));
+
+    b = *Board::init("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    EXPECT_FALSE(has_legal_move(b, at));
+    EXPECT_EQ(MateStatus::STALEMATE, mate_status(b, at));
+
+    // mated by a pawn on the back rank, for both colours
+    b = *Board::init("6bk/6P1/7K/8/8/8/8/8 b - - 0 1");
+    EXPECT_FALSE(has_legal_move(b, at));
+    EXPECT_EQ(MateStatus::CHECKMATE, mate_status(b, at));
+    b = *Board::init("8/8/8/8/8/7k/6p1/6BK w - - 0 1");
+    EXPECT_FALSE(has_legal_move(b, at));
+    EXPECT_EQ(MateStatus::CHECKMATE, mate_status(b, at));
+
+    // in check but can escape
+    b = *Board::init("4k3/8/8/8/8/8/4r3/4K3 w - - 0 1");
+    EXPECT_TRUE(has_legal_move(b, at));
+    EXPECT_EQ(MateStatus::NONE, mate_status(b, at));
+}
+
+// Every move generated in a set of related positions is checked against every position in the
+// set, so is_legal sees plenty of moves that are legal somewhere else but not here, the same
+// as a hash or killer move would be
+TEST_F(TestMoveGen, TestIsLegal) {
+    const std::vector<std::string_view> fens {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/8/8/6K1/k2pP2R/8/8/8 b - e3 0 50",
+        "4k1r1/8/8/8/8/8/8/R3K2R w KQ - 3 40",
+    };
+
+    for (const auto fen : fens) {
+        Board root { *Board::init(fen) };
+        std::vector<Board> positions { root };
+        std::vector<EncodedMove> root_moves;
+        MoveGen(root_moves, root, at).gen();
+        for (const auto move : root_moves) {
+            Board child { root };
+            child.make_move(move);
+            positions.push_back(child);
+        }
+
+        std::vector<EncodedMove> pool;
+        for (const auto &position : positions) {
+            MoveGen::for_each(position, at, [&pool](const EncodedMove move) {
+                pool.push_back(move);
+            });
+        }
+
+        for (const auto &position : positions) {
+            std::vector<EncodedMove> legal;
+            MoveGen(legal, position, at).gen();
+            for (const auto move : pool) {
+                const bool expected {
+                    std::find(legal.begin(), legal.end(), move) != legal.end()
+                };
+                EXPECT_EQ(expected, is_legal(position, at, move)) << fen << " " << move;
+                if (expected) {
+                    EXPECT_TRUE(is_pseudo_legal(position, at, move)) << fen << " " << move;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestMoveGen, TestIsPseudoLegal) {
+    // the c6 knight is pinned, moving it is pseudo-legal but not legal
+    Board b { *Board::init("r1bqkbnr/ppp2ppp/2np4/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 1 4") };
+    const EncodedMove pinned_knight(MoveType::QUIET, C6, E7, KNIGHT, BLACK, NUM_PIECES, NUM_PIECES);
+    EXPECT_TRUE(is_pseudo_legal(b, at, pinned_knight));
+    EXPECT_FALSE(is_legal(b, at, pinned_knight));
+
+    // wrong captured piece
+    b = *Board::init("r1bqkbnr/1ppp1ppp/p1B5/4p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 0 4");
+    EXPECT_TRUE(is_legal(b, at, EncodedMove(MoveType::CAPTURE, D7, C6, PAWN, BLACK, BISHOP,
+                                            NUM_PIECES)));
+    EXPECT_FALSE(is_pseudo_legal(b, at, EncodedMove(MoveType::CAPTURE, D7, C6, PAWN, BLACK,
+                                                    KNIGHT, NUM_PIECES)));
+    // wrong side to move
+    EXPECT_FALSE(is_pseudo_legal(b, at, EncodedMove(MoveType::QUIET, G1, H3, KNIGHT, WHITE,
+                                                    NUM_PIECES, NUM_PIECES)));
+
+    // castling through an attacked square is pseudo-legal but not legal
+    b = *Board::init("4k3/8/8/8/8/8/5r2/R3K2R w KQ - 0 1");
+    const EncodedMove castle(MoveType::CASTLE_KINGSIDE, E1, G1, KING, WHITE, NUM_PIECES,
+                             NUM_PIECES);
+    EXPECT_TRUE(is_pseudo_legal(b, at, castle));
+    EXPECT_FALSE(is_legal(b, at, castle));
+}
+
+// Filtering pseudo-legal generation with legal_after_pseudo has to give exactly the legal moves,
+// checked over each position and its children so checks, pins and en-passant all turn up
+TEST_F(TestMoveGen, TestPseudoLegalFiltered) {
+    const std::vector<std::string_view> fens {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/8/6K1/k2pP2R/8/8/8 b - e3 0 50",
+        "4k1r1/8/8/8/8/8/8/R3K2R w KQ - 3 40",
+    };
+
+    for (const auto fen : fens) {
+        const Board root { *Board::init(fen) };
+        std::vector<Board> positions { root };
+        std::vector<EncodedMove> root_moves;
+        MoveGen(root_moves, root, at).gen();
+        for (const auto move : root_moves) {
+            Board child { root };
+            child.make_move(move);
+            positions.push_back(child);
+        }
+
+        for (const auto &position : positions) {
+            std::vector<EncodedMove> legal;
+            MoveGen(legal, position, at).gen();
+            std::vector<EncodedMove> pseudo_legal;
+            MoveGen(pseudo_legal, position, at).gen_pseudo_legal();
+            std::vector<EncodedMove> filtered;
+            std::copy_if(pseudo_legal.begin(), pseudo_legal.end(), std::back_inserter(filtered),
+                         [&](const EncodedMove move) {
+                             return legal_after_pseudo(position, at, move);
+                         });
+            EXPECT_EQ(legal.size(), filtered.size()) << fen;
+            EXPECT_TRUE(std::is_permutation(legal.begin(), legal.end(), filtered.begin(),
+                                            filtered.end())) << fen;
+        }
+    }
+}
+
+TEST_F(TestMoveGen, TestCaptures) {
+    const std::vector<std::string_view> fens {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/8/6K1/k2pP2R/8/8/8 b - e3 0 50",
+    };
+
+    for (const auto fen : fens) {
+        const Board root { *Board::init(fen) };
+        std::vector<Board> positions { root };
+        std::vector<EncodedMove> root_moves;
+        MoveGen(root_moves, root, at).gen();
+        for (const auto move : root_moves) {
+            Board child { root };
+            child.make_move(move);
+            positions.push_back(child);
+        }
+
+        for (const auto &position : positions) {
+            std::vector<EncodedMove> legal;
+            MoveGen(legal, position, at).gen();
+            std::vector<EncodedMove> captures;
+            MoveGen(captures, position, at).gen_captures();
+
+            // everything when in check, otherwise just the captures and promotions
+            std::vector<EncodedMove> expected;
+            const bool in_check {
+                king_in_check(position.bitboard(), at, position.turn_colour())
+            };
+            std::copy_if(legal.begin(), legal.end(), std::back_inserter(expected),
+                         [&](const EncodedMove move) {
+                             return in_check || move.captured_piece < NUM_PIECES ||
+                                    move.promoted_piece < NUM_PIECES;
+                         });
+            EXPECT_EQ(expected.size(), captures.size()) << fen;
+            EXPECT_TRUE(std::is_permutation(expected.begin(), expected.end(), captures.begin(),
+                                            captures.end())) << fen;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "board.h"
+#include "move_ordering.h"
+#include "move_parse.h"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+class TestMoveOrdering : public testing::Test {
+protected:
+    // white has Nxd5, a quiet knight move and a quiet rook move
+    static constexpr std::string_view FEN { "4k3/8/8/3p4/8/2N5/8/R3K3 w - - 0 1" };
+
+    static EncodedMove move(const Board &board, const std::string_view input) {
+        const auto parsed { parse_move_input(input, board) };
+        EXPECT_TRUE(parsed.has_value());
+        return *parsed;
+    }
+
+    static std::vector<int> scores_of(const MoveOrdering &ordering,
+                                      const std::vector<EncodedMove> &moves,
+                                      const PackedMove hash_move,
+                                      const std::optional<EncodedMove> previous = std::nullopt) {
+        std::vector<int> scores;
+        ordering.score(moves, scores, 1, hash_move, previous);
+        return scores;
+    }
+};
+
+TEST_F(TestMoveOrdering, TestMvvLva) {
+    const auto board { Board::init("4k3/8/8/3q4/4P3/2N5/8/4K3 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    // the pawn taking the queen beats the knight taking it
+    EXPECT_GT(mvv_lva(move(*board, "e4d5")), mvv_lva(move(*board, "c3d5")));
+    EXPECT_FALSE(is_quiet(move(*board, "e4d5")));
+    EXPECT_TRUE(is_quiet(move(*board, "c3b5")));
+}
+
+TEST_F(TestMoveOrdering, TestPickerOrder) {
+    const auto board { Board::init(FEN) };
+    ASSERT_TRUE(board.has_value());
+    std::vector<EncodedMove> moves {
+        move(*board, "a1a2"), move(*board, "c3d5"), move(*board, "c3b5"), move(*board, "a1a8")
+    };
+    std::vector<int> scores { 1, 7, -3, 5 };
+    MovePicker picker { moves, scores };
+    for (const auto expected : { "c3d5", "a1a8", "a1a2", "c3b5" }) {
+        const auto next { picker.next() };
+        ASSERT_TRUE(next.has_value());
+        EXPECT_EQ(expected, move_to_string(*next));
+    }
+    EXPECT_FALSE(picker.next().has_value());
+}
+
+TEST_F(TestMoveOrdering, TestScoreBands) {
+    auto board { Board::init(FEN) };
+    ASSERT_TRUE(board.has_value());
+    const EncodedMove capture { move(*board, "c3d5") };
+    const EncodedMove hash { move(*board, "a1a3") };
+    const EncodedMove killer { move(*board, "c3b5") };
+    const EncodedMove counter { move(*board, "a1a2") };
+    const EncodedMove history { move(*board, "a1b1") };
+    const EncodedMove other { move(*board, "a1c1") };
+    board->make_move(move(*board, "a1a8"));
+    const EncodedMove previous { move(*board, "e8e7") };
+    board->undo_last_move();
+
+    MoveOrdering ordering { 8 };
+    // the history move gets its bonus from a cutoff at another ply, so it isn't a killer here
+    ordering.quiet_cutoff(history, {}, 2, 4, std::nullopt);
+    ordering.quiet_cutoff(counter, {}, 3, 2, previous);
+    ordering.quiet_cutoff(killer, {}, 1, 4, std::nullopt);
+
+    const std::vector<EncodedMove> moves { other, history, counter, killer, capture, hash };
+    const auto scores { scores_of(ordering, moves, pack_move(hash), previous) };
+    for (std::size_t i = 1; i < moves.size(); ++i) {
+        EXPECT_GT(scores[i], scores[i-1]) << move_to_string(moves[i]);
+    }
+    // without the previous move there's no countermove
+    const auto no_previous { scores_of(ordering, moves, pack_move(hash)) };
+    EXPECT_LT(no_previous[2], no_previous[1]);
+}
+
+TEST_F(TestMoveOrdering, TestQuietCutoff) {
+    const auto board { Board::init(FEN) };
+    ASSERT_TRUE(board.has_value());
+    const EncodedMove first { move(*board, "c3b5") };
+    const EncodedMove second { move(*board, "a1a2") };
+    const EncodedMove tried { move(*board, "a1b1") };
+    const std::vector<EncodedMove> moves { first, second, tried };
+
+    MoveOrdering ordering { 8 };
+    ordering.quiet_cutoff(first, {}, 1, 3, std::nullopt);
+    ordering.quiet_cutoff(second, std::vector { tried }, 1, 3, std::nullopt);
+    auto scores { scores_of(ordering, moves, 0) };
+    // the newest killer goes in the first slot
+    EXPECT_GT(scores[1], scores[0]);
+    // and the quiet that was tried before the cutoff loses history
+    EXPECT_LT(scores[2], 0);
+
+    ordering.clear_killers(1);
+    scores = scores_of(ordering, moves, 0);
+    EXPECT_GT(scores[0], 0);
+    EXPECT_LT(scores[0], MoveOrdering::MAX_HISTORY);
+
+    ordering.clear();
+    scores = scores_of(ordering, moves, 0);
+    EXPECT_EQ((std::vector { 0, 0, 0 }), scores);
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "perf_counters.h"
+
+#include <sstream>
+
+TEST(TestPerfCounters, TestIpc) {
+    PerfSample sample {};
+    EXPECT_FALSE(sample.ipc().has_value());
+    sample.counts[static_cast<std::size_t>(PerfEvent::CYCLES)] = 200;
+    EXPECT_FALSE(sample.ipc().has_value());
+    sample.counts[static_cast<std::size_t>(PerfEvent::INSTRUCTIONS)] = 500;
+    EXPECT_DOUBLE_EQ(2.5, *sample.ipc());
+}
+
+// Whether there are any counters depends on the machine, either way it shouldn't fail
+TEST(TestPerfCounters, TestStartStop) {
+    PerfCounters counters;
+    counters.start();
+    volatile std::uint64_t sum {};
+    for (std::uint64_t i = 0; i < 100000; ++i) {
+        sum = sum + i;
+    }
+    const PerfSample sample { counters.stop() };
+    if (!counters.available()) {
+        EXPECT_FALSE(counters.error().empty());
+        for (const auto &count : sample.counts) {
+            EXPECT_FALSE(count.has_value());
+        }
+    } else if (const auto instructions { sample[PerfEvent::INSTRUCTIONS] }) {
+        EXPECT_GT(*instructions, 100000u);
+    }
+
+    std::ostringstream out;
+    print_perf_sample(out, sample, 1000);
+    EXPECT_NE(std::string::npos, out.str().find("IPC"));
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "attack_table.h"
+#include "board.h"
+#include "perft.h"
+#include "perft_progress.h"
+#include "perft_table.h"
+#include "unique_positions.h"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+class TestPerft : public testing::Test {
+protected:
+    static const AttackTable at;
+};
+
+const AttackTable TestPerft::at {};
+
+TEST(TestEpd, TestParseLine) {
+    const auto entry {
+        parse_epd_line("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400")
+    };
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", entry->fen);
+    const std::vector<std::pair<int, std::uint64_t>> expected { { 1, 20 }, { 2, 400 } };
+    EXPECT_EQ(expected, entry->expected);
+}
+
+TEST(TestEpd, TestParseLineNoCounts) {
+    const auto entry { parse_epd_line("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -\r") };
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", entry->fen);
+    EXPECT_TRUE(entry->expected.empty());
+}
+
+TEST(TestEpd, TestParseLineInvalid) {
+    EXPECT_FALSE(parse_epd_line("").has_value());
+    EXPECT_FALSE(parse_epd_line(" ;D1 20").has_value());
+    EXPECT_FALSE(parse_epd_line("8/8/8/8/8/8/8/8 w - - ;D1").has_value());
+    EXPECT_FALSE(parse_epd_line("8/8/8/8/8/8/8/8 w - - ;X1 20").has_value());
+    EXPECT_FALSE(parse_epd_line("8/8/8/8/8/8/8/8 w - - ;D0 1").has_value());
+    EXPECT_FALSE(parse_epd_line("8/8/8/8/8/8/8/8 w - - ;D1 2x").has_value());
+}
+
+TEST(TestEpd, TestParseGenMode) {
+    EXPECT_EQ(GenMode::LEGAL, parse_gen_mode("legal"));
+    EXPECT_EQ(GenMode::PSEUDO_LEGAL, parse_gen_mode("pseudo"));
+    EXPECT_FALSE(parse_gen_mode("fast").has_value());
+}
+
+TEST_F(TestPerft, TestPerftStrategiesAgree) {
+    Board b { *Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -") };
+    EXPECT_EQ(1ul, perft(b, at, 0));
+    EXPECT_EQ(48ul, perft(b, at, 1));
+    EXPECT_EQ(97862ul, perft(b, at, 3));
+    EXPECT_EQ(97862ul, perft(b, at, 3, GenMode::PSEUDO_LEGAL));
+}
+
+// Counts from the published perft results tables
+TEST_F(TestPerft, TestPerftStats) {
+    struct StatsCase {
+        std::string_view fen;
+        int depth;
+        PerftStats expected;
+    };
+    const std::vector<StatsCase> cases {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4,
+          { 197281, 1576, 0, 0, 0, 469, 0, 0, 8 } },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 3,
+          { 97862, 17102, 45, 3162, 0, 993, 0, 0, 1 } },
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", 4,
+          { 43238, 3348, 123, 0, 0, 1680, 106, 0, 17 } },
+        { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3,
+          { 9467, 1021, 4, 0, 120, 38, 2, 0, 22 } },
+    };
+
+    for (const auto &c : cases) {
+        Board b { *Board::init(c.fen) };
+        std::vector<PerftStats> by_ply(c.depth);
+        perft_stats(b, at, c.depth, by_ply);
+        EXPECT_EQ(c.expected, by_ply.back()) << c.fen;
+        // and the shallower depths are the plain perft counts
+        for (int depth = 1; depth < c.depth; ++depth) {
+            EXPECT_EQ(perft(b, at, depth), by_ply[depth-1].nodes) << c.fen;
+        }
+    }
+}
+
+// Distinct positions after n plies from the start, OEIS A083276
+TEST_F(TestPerft, TestUniquePositions) {
+    const Board b { *Board::init() };
+    const auto tmp { std::filesystem::temp_directory_path() };
+    const auto three { count_unique_positions(b, at, 3, 2, 1 << 20, tmp) };
+    EXPECT_EQ(8902ul, three.paths);
+    EXPECT_EQ(5362ul, three.unique);
+    EXPECT_EQ(0ul, three.spilled_runs);
+
+    const auto four { count_unique_positions(b, at, 4, 2, 1 << 20, tmp) };
+    EXPECT_EQ(197281ul, four.paths);
+    EXPECT_EQ(72078ul, four.unique);
+
+    // a budget small enough that most of it goes through disk
+    const auto spilled { count_unique_positions(b, at, 4, 3, 1 << 10, tmp) };
+    EXPECT_EQ(72078ul, spilled.unique);
+    EXPECT_GT(spilled.spilled_runs, 0ul);
+}
+
+TEST_F(TestPerft, TestMirroredPerft) {
+    for (const auto fen : {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    }) {
+        Board board { *Board::init(fen) };
+        Board mirror { board.mirrored() };
+        EXPECT_EQ(perft(board, at, 3), perft(mirror, at, 3)) << fen;
+    }
+}
+
+TEST_F(TestPerft, TestPerftTable) {
+    const std::vector<std::pair<std::string_view, std::vector<std::uint64_t>>> positions {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+          { 20, 400, 8902, 197281, 4865609 } },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+          { 48, 2039, 97862, 4085603 } },
+    };
+    for (const bool canonical : { false, true }) {
+        // small enough that entries get replaced
+        PerftTable table { 1 << 12 };
+        for (const auto &[fen, expected] : positions) {
+            Board board { *Board::init(fen) };
+            for (std::size_t depth = 1; depth <= expected.size(); ++depth) {
+                EXPECT_EQ(expected[depth-1], perft(board, at, depth, table, canonical))
+                    << fen << " depth " << depth;
+            }
+        }
+        EXPECT_GT(table.hits(), 0u);
+    }
+
+    // the mirrored position finds everything its mirror stored
+    PerftTable table { 1 << 24 };
+    Board board { *Board::init(positions[1].first) };
+    Board mirror { board.mirrored() };
+    perft(board, at, 3, table, true);
+    const auto hits { table.hits() };
+    EXPECT_EQ(97862u, perft(mirror, at, 3, table, true));
+    EXPECT_EQ(hits + 1, table.hits());
+}
+
+TEST_F(TestPerft, TestPerftProgress) {
+    Board board { *Board::init() };
+    PerftProgress progress;
+    EXPECT_EQ(197281u, perft(board, at, 4, GenMode::LEGAL, &progress));
+    // only published in batches
+    EXPECT_EQ(0u, progress.published());
+    progress.publish();
+    EXPECT_EQ(197281u, progress.published());
+
+    PerftTable table { 1 << 20 };
+    EXPECT_EQ(4865609u, perft(board, at, 5, table, false, GenMode::LEGAL, &progress));
+    progress.publish();
+    // cached subtrees count too
+    EXPECT_EQ(197281u + 4865609u, progress.published());
+}
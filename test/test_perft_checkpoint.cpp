@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "perft_checkpoint.h"
+
+#include <sstream>
+
+TEST(TestPerftCheckpoint, TestLoad) {
+    std::istringstream in {
+        "perft 5 startpos\n"
+        "e2e4 9771632\n"
+        "d2d4 e7e5 32345\n"
+        "g1f3 1236\n"
+    };
+    const auto done { load_checkpoint(in, "perft 5 startpos") };
+    ASSERT_TRUE(done.has_value());
+    EXPECT_EQ(3ul, done->size());
+    EXPECT_EQ(9771632ul, done->at("e2e4"));
+    EXPECT_EQ(32345ul, done->at("d2d4 e7e5"));
+}
+
+TEST(TestPerftCheckpoint, TestLoadTornLastLine) {
+    // killed in the middle of writing the count of the last line
+    std::istringstream in { "perft 5 startpos\ne2e4 9771632\nd2d4 e7e5 32" };
+    const auto done { load_checkpoint(in, "perft 5 startpos") };
+    ASSERT_TRUE(done.has_value());
+    EXPECT_EQ(1ul, done->size());
+    EXPECT_FALSE(done->contains("d2d4 e7e5"));
+}
+
+TEST(TestPerftCheckpoint, TestLoadWrongRun) {
+    std::istringstream in { "perft 6 startpos\ne2e4 9771632\n" };
+    EXPECT_FALSE(load_checkpoint(in, "perft 5 startpos").has_value());
+}
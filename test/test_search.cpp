@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include "attack_table.h"
+#include "board.h"
+#include "eval.h"
+#include "move_gen.h"
+#include "move_parse.h"
+#include "search.h"
+#include "search_bench.h"
+#include "transposition_table.h"
+
+#include <string_view>
+#include <vector>
+
+class TestSearch : public testing::Test {
+protected:
+    static const AttackTable at;
+    TranspositionTable tt { 1 };
+};
+
+const AttackTable TestSearch::at {};
+
+TEST(TestEval, TestSymmetric) {
+    auto board { Board::init() };
+    ASSERT_TRUE(board.has_value());
+    EXPECT_EQ(0, eval::evaluate(*board));
+
+    for (const std::string_view fen : {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R b KQ - 1 8",
+    }) {
+        board = Board::init(fen);
+        ASSERT_TRUE(board.has_value());
+        EXPECT_EQ(eval::evaluate(*board), eval::evaluate(board->mirrored())) << fen;
+    }
+}
+
+TEST_F(TestSearch, TestMateInOne) {
+    auto board { Board::init("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt };
+    const auto result { search.run(*board, SearchLimits { 4, 0, {} }) };
+    ASSERT_TRUE(result.best_move.has_value());
+    EXPECT_EQ("a1a8", move_to_string(*result.best_move));
+    EXPECT_EQ(score::MATE - 1, result.score);
+    EXPECT_EQ("mate 1", score::to_string(result.score));
+
+    // a pawn giving mate to a king on its back rank
+    board = Board::init("6bk/8/6PK/8/8/8/8/8 w - - 0 1");
+    ASSERT_TRUE(board.has_value());
+    const auto pawn_mate { search.run(*board, SearchLimits { 5, 0, {} }) };
+    ASSERT_TRUE(pawn_mate.best_move.has_value());
+    EXPECT_EQ("g6g7", move_to_string(*pawn_mate.best_move));
+    EXPECT_EQ(score::MATE - 1, pawn_mate.score);
+}
+
+TEST_F(TestSearch, TestMateInTwo) {
+    auto board { Board::init("7k/8/8/8/8/8/R7/1R4K1 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    const std::string fen { board->to_fen() };
+    Search search { at, tt };
+    const auto result { search.run(*board, SearchLimits { 5, 0, {} }) };
+    EXPECT_EQ(score::MATE - 3, result.score);
+    EXPECT_EQ("mate 2", score::to_string(result.score));
+    EXPECT_EQ(fen, board->to_fen());
+
+    // the PV has to be playable and end in mate
+    ASSERT_EQ(3, result.pv.size());
+    for (const auto move : result.pv) {
+        ASSERT_TRUE(is_legal(*board, at, move));
+        board->make_move(move);
+    }
+    std::vector<EncodedMove> moves;
+    MoveGen(moves, *board, at).gen();
+    EXPECT_TRUE(moves.empty());
+}
+
+TEST_F(TestSearch, TestNoLegalMoves) {
+    Search search { at, tt };
+    auto stalemate { Board::init("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1") };
+    ASSERT_TRUE(stalemate.has_value());
+    auto result { search.run(*stalemate, SearchLimits { 3, 0, {} }) };
+    EXPECT_FALSE(result.best_move.has_value());
+    EXPECT_EQ(0, result.score);
+
+    auto checkmate { Board::init("R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1") };
+    ASSERT_TRUE(checkmate.has_value());
+    result = search.run(*checkmate, SearchLimits { 3, 0, {} });
+    EXPECT_FALSE(result.best_move.has_value());
+    EXPECT_EQ(-score::MATE, result.score);
+
+    checkmate = Board::init("6bk/6P1/7K/8/8/8/8/8 b - - 0 1");
+    ASSERT_TRUE(checkmate.has_value());
+    result = search.run(*checkmate, SearchLimits { 3, 0, {} });
+    EXPECT_FALSE(result.best_move.has_value());
+    EXPECT_EQ(-score::MATE, result.score);
+}
+
+TEST_F(TestSearch, TestQuiesceInCheck) {
+    // at depth 1 the mate is only seen if the quiescence search knows it's in check after g7,
+    // rather than standing pat
+    auto board { Board::init("6bk/8/6PK/8/8/8/8/8 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt };
+    const auto result { search.run(*board, SearchLimits { 1, 0, {} }) };
+    ASSERT_TRUE(result.best_move.has_value());
+    EXPECT_EQ("g6g7", move_to_string(*result.best_move));
+    EXPECT_EQ(score::MATE - 1, result.score);
+    EXPECT_GT(result.stats.qnodes, 0u);
+}
+
+TEST_F(TestSearch, TestLateCheck) {
+    // after Kh8 white's mate, g7, is a quiet move that comes after five captures, late enough
+    // to be pruned if it wasn't seen to give check
+    auto board { Board::init("8/5K1k/3p2P1/3P1NN1/3p3p/3P1p1p/5P1P/8 b - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt };
+    const auto result { search.run(*board, SearchLimits { 2, 0, {} }) };
+    EXPECT_EQ(-(score::MATE - 2), result.score);
+    ASSERT_EQ(2, result.pv.size());
+    EXPECT_EQ("g6g7", move_to_string(result.pv[1]));
+}
+
+TEST_F(TestSearch, TestNoNullMoveInCheck) {
+    // white's only moves take on g7 with a check on the back rank, and white has nothing but
+    // pawns so never passes itself. Up to depth 5 the only nodes deep enough for a null move
+    // are black's, in check, so there can't be any null move cutoffs.
+    auto board { Board::init("7k/5pnp/5P1P/8/8/p2n4/P2n4/K7 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt };
+    for (const int depth : { 4, 5 }) {
+        const auto result { search.run(*board, SearchLimits { depth, 0, {} }) };
+        EXPECT_EQ(depth, result.depth);
+        EXPECT_EQ(0u, result.stats.null_cutoffs) << depth;
+    }
+}
+
+TEST_F(TestSearch, TestLimits) {
+    auto board { Board::init() };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt };
+
+    int iterations {};
+    auto result {
+        search.run(*board, SearchLimits { 3, 0, {} }, [&](const IterationInfo &info) {
+            EXPECT_EQ(++iterations, info.depth);
+            EXPECT_EQ(info.depth, static_cast<int>(info.pv.size()));
+        })
+    };
+    EXPECT_EQ(3, iterations);
+    EXPECT_EQ(3, result.depth);
+    ASSERT_TRUE(result.best_move.has_value());
+
+    // the first iteration always finishes, after that it stops as soon as the limit's hit
+    result = search.run(*board, SearchLimits { 0, 5000, {} });
+    EXPECT_EQ(5000, result.nodes);
+    EXPECT_GE(result.depth, 1);
+    EXPECT_TRUE(result.best_move.has_value());
+
+    result = search.run(*board, SearchLimits { 0, 0, std::chrono::milliseconds(50) });
+    EXPECT_GE(result.depth, 1);
+    EXPECT_TRUE(result.best_move.has_value());
+}
+
+TEST_F(TestSearch, TestThreads) {
+    auto board { Board::init("7k/8/8/8/8/8/R7/1R4K1 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    const std::string fen { board->to_fen() };
+    Search search { at, tt, 4 };
+    EXPECT_EQ(4, search.threads());
+    auto result { search.run(*board, SearchLimits { 5, 0, {} }) };
+    EXPECT_EQ(score::MATE - 3, result.score);
+    EXPECT_EQ(fen, board->to_fen());
+
+    board = Board::init();
+    ASSERT_TRUE(board.has_value());
+    int iterations {};
+    result = search.run(*board, SearchLimits { 4, 0, {} }, [&](const IterationInfo &info) {
+        // only the main thread reports, so every depth once and in order
+        EXPECT_EQ(++iterations, info.depth);
+    });
+    EXPECT_EQ(4, iterations);
+    EXPECT_EQ(4, result.depth);
+    EXPECT_TRUE(result.best_move.has_value());
+
+    // the helpers stop with the main thread
+    result = search.run(*board, SearchLimits { 0, 0, std::chrono::milliseconds(50) });
+    EXPECT_TRUE(result.best_move.has_value());
+}
+
+TEST_F(TestSearch, TestAbdada) {
+    auto board { Board::init("7k/8/8/8/8/8/R7/1R4K1 w - - 0 1") };
+    ASSERT_TRUE(board.has_value());
+    Search search { at, tt, 4, ParallelMode::ABDADA };
+    auto result { search.run(*board, SearchLimits { 5, 0, {} }) };
+    EXPECT_EQ(score::MATE - 3, result.score);
+
+    // deep enough that moves get deferred
+    board = Board::init("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    ASSERT_TRUE(board.has_value());
+    const std::string fen { board->to_fen() };
+    result = search.run(*board, SearchLimits { 5, 0, {} });
+    EXPECT_EQ(5, result.depth);
+    EXPECT_EQ(fen, board->to_fen());
+    ASSERT_TRUE(result.best_move.has_value());
+    EXPECT_TRUE(is_legal(*board, at, *result.best_move));
+}
+
+TEST(TestParallelMode, TestParse) {
+    for (const auto mode : { ParallelMode::LAZY_SMP, ParallelMode::ABDADA }) {
+        EXPECT_EQ(mode, parse_parallel_mode(parallel_mode_name(mode)));
+    }
+    EXPECT_FALSE(parse_parallel_mode("ybwc").has_value());
+}
+
+TEST(TestSearchBench, TestDoublingThreadCounts) {
+    EXPECT_EQ(std::vector<unsigned>({ 1 }), doubling_thread_counts(1));
+    EXPECT_EQ(std::vector<unsigned>({ 1, 2, 4, 8 }), doubling_thread_counts(8));
+    EXPECT_EQ(std::vector<unsigned>({ 1, 2, 4, 6 }), doubling_thread_counts(6));
+    EXPECT_EQ(std::vector<unsigned>({ 1 }), doubling_thread_counts(0));
+}
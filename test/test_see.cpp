@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "attack_table.h"
+#include "board.h"
+#include "move_parse.h"
+#include "see.h"
+
+#include <string_view>
+
+class TestSee : public testing::Test {
+protected:
+    static const AttackTable at;
+
+    static int see_of(const std::string_view fen, const std::string_view move_input) {
+        const auto board { Board::init(fen) };
+        EXPECT_TRUE(board.has_value());
+        const auto move { parse_move_input(move_input, *board) };
+        EXPECT_TRUE(move.has_value());
+        EXPECT_EQ(see(*board, at, *move) >= 0, see_ge(*board, at, *move, 0));
+        return see(*board, at, *move);
+    }
+};
+
+const AttackTable TestSee::at {};
+
+TEST_F(TestSee, TestUndefended) {
+    EXPECT_EQ(100, see_of("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5"));
+    // quiet moves to a safe square don't gain or lose anything
+    EXPECT_EQ(0, see_of("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1f1"));
+}
+
+TEST_F(TestSee, TestLosingCapture) {
+    // Nxe5, Nxe5, Rxe5, Bxe5, Qxe5, Qxe5: a pawn for the knight
+    EXPECT_EQ(-220, see_of("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5"));
+    EXPECT_EQ(-400, see_of("4k3/8/3p4/4p3/8/8/8/4R1K1 w - - 0 1", "e1e5"));
+}
+
+TEST_F(TestSee, TestXRay) {
+    // the second rook only joins in once the first has gone
+    EXPECT_EQ(100, see_of("4k3/4r3/8/4p3/8/8/4R3/4R1K1 w - - 0 1", "e2e5"));
+    // a queen behind a bishop, bishop and pawn for knight and pawn
+    EXPECT_EQ(90, see_of("4k3/8/5p2/4n3/8/2B5/1Q6/6K1 w - - 0 1", "c3e5"));
+}
+
+TEST_F(TestSee, TestKingRecapture) {
+    // the king can't take back, the pawn defends e5
+    EXPECT_EQ(100, see_of("8/8/3k4/4p3/5P2/8/8/4R1K1 w - - 0 1", "e1e5"));
+    // here it can
+    EXPECT_EQ(-400, see_of("8/8/3k4/4p3/8/8/8/4R1K1 w - - 0 1", "e1e5"));
+}
+
+TEST_F(TestSee, TestPawnDefendsBackRank) {
+    // c7xd8=Q takes the queen back, and the same for black's pawn on the first rank
+    EXPECT_EQ(-400, see_of("3R3k/2P5/8/3q4/8/8/8/7K b - - 0 1", "d5d8"));
+    EXPECT_EQ(-400, see_of("7k/8/8/8/3Q4/8/2p5/3r3K w - - 0 1", "d4d1"));
+}
+
+TEST_F(TestSee, TestSpecialMoves) {
+    EXPECT_EQ(100, see_of("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6"));
+    // promoting on a defended square loses the pawn, not the queen's worth
+    EXPECT_EQ(800, see_of("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7b8q"));
+    EXPECT_EQ(-100, see_of("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q"));
+}
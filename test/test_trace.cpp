@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "trace.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static std::size_t count_of(const std::string &s, const std::string &what) {
+    std::size_t count {};
+    for (auto pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST(TestTrace, TestDisabledRecordsNothing) {
+    trace::disable();
+    trace::clear();
+    {
+        const trace::Scope scope { "untraced", "test" };
+    }
+    std::ostringstream out;
+    trace::write_json(out);
+    EXPECT_EQ(std::string::npos, out.str().find("untraced"));
+}
+
+TEST(TestTrace, TestThreadsGetTheirOwnTimeline) {
+    trace::clear();
+    trace::enable();
+    const auto work { [](const std::string &name) {
+        trace::set_thread_name(name);
+        for (std::uint64_t i = 0; i < 10; ++i) {
+            const trace::Scope scope { "task", "test", "index", i };
+        }
+    } };
+    std::thread a(work, "first \"quoted\"");
+    std::thread b(work, "second");
+    a.join();
+    b.join();
+    trace::disable();
+
+    std::ostringstream out;
+    trace::write_json(out);
+    const std::string json { out.str() };
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_EQ(20u, count_of(json, "\"name\":\"task\",\"cat\":\"test\",\"ph\":\"B\""));
+    EXPECT_EQ(20u, count_of(json, "\"name\":\"task\",\"cat\":\"test\",\"ph\":\"E\""));
+    EXPECT_EQ(2u, count_of(json, "\"args\":{\"index\":9}"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"first \\\"quoted\\\"\"}"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"second\"}"));
+    EXPECT_EQ(0u, trace::dropped());
+    trace::clear();
+}
+
+TEST(TestTrace, TestOutput) {
+    // without a path there's nothing to write, so the exit code is passed on
+    EXPECT_EQ(3, trace::Output { std::nullopt }.finish(3));
+
+    const std::string path { testing::TempDir() + "fenrir_test_trace.json" };
+    {
+        trace::Output output { path, "test main" };
+        EXPECT_TRUE(trace::enabled());
+        EXPECT_EQ(2, output.finish(2));
+    }
+    std::ifstream in(path);
+    const std::string json { std::istreambuf_iterator<char>(in), {} };
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"test main\"}"));
+    std::filesystem::remove(path);
+
+    // a trace that can't be written fails the run
+    EXPECT_EQ(1, trace::Output { "/nonexistent/fenrir/trace.json" }.finish(0));
+    trace::disable();
+    trace::clear();
+}
+
+TEST(TestTrace, TestOverflowKeepsScopesMatched) {
+    trace::clear();
+    trace::enable();
+    // far more events than a buffer holds, so the outer begin and the oldest inner ones are
+    // overwritten
+    std::thread([] {
+        const trace::Scope outer { "outer", "test" };
+        for (std::uint64_t i = 0; i < 100'000; ++i) {
+            const trace::Scope inner { "inner", "test" };
+        }
+    }).join();
+    trace::disable();
+
+    std::ostringstream out;
+    trace::write_json(out);
+    const std::string json { out.str() };
+    EXPECT_GT(trace::dropped(), 0u);
+    EXPECT_EQ(std::string::npos, json.find("\"name\":\"outer\""));
+    const std::size_t begins { count_of(json, "\"ph\":\"B\"") };
+    EXPECT_GT(begins, 0u);
+    EXPECT_EQ(begins, count_of(json, "\"ph\":\"E\""));
+    trace::clear();
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include "board.h"
+#include "move_parse.h"
+#include "transposition_table.h"
+
+#include <cstdint>
+
+TEST(TestTranspositionTable, TestStoreProbe) {
+    TranspositionTable tt { 1 };
+    constexpr std::uint64_t key { 0x123456789ABCDEF0 };
+    EXPECT_FALSE(tt.probe(key).has_value());
+
+    tt.store(key, 0x1234, -31000, 12, Bound::LOWER);
+    const auto entry { tt.probe(key) };
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(0x1234, entry->move);
+    EXPECT_EQ(-31000, entry->score);
+    EXPECT_EQ(12, entry->depth);
+    EXPECT_EQ(Bound::LOWER, entry->bound);
+
+    // no move keeps the one already there
+    tt.store(key, 0, 25, 13, Bound::EXACT);
+    EXPECT_EQ(0x1234, tt.probe(key)->move);
+    EXPECT_EQ(25, tt.probe(key)->score);
+
+    // a much shallower bound doesn't replace a deep result
+    tt.store(key, 0x4321, 50, 2, Bound::UPPER);
+    EXPECT_EQ(13, tt.probe(key)->depth);
+
+    EXPECT_FALSE(tt.probe(key ^ 1).has_value());
+    tt.clear(4);
+    EXPECT_FALSE(tt.probe(key).has_value());
+}
+
+TEST(TestTranspositionTable, TestReplacement) {
+    // one bucket, so every key shares it
+    TranspositionTable tt { 0 };
+    for (std::uint64_t key = 1; key <= 4; ++key) {
+        tt.store(key, 0, 0, static_cast<int>(key) + 10, Bound::EXACT);
+    }
+    tt.store(5, 0, 0, 1, Bound::EXACT);
+    // the shallowest went
+    EXPECT_FALSE(tt.probe(1).has_value());
+    EXPECT_TRUE(tt.probe(5).has_value());
+
+    // entries from an older search go before deeper ones from this one
+    tt.new_search();
+    tt.store(6, 0, 0, 10, Bound::EXACT);
+    tt.store(7, 0, 0, 10, Bound::EXACT);
+    EXPECT_FALSE(tt.probe(2).has_value());
+    EXPECT_FALSE(tt.probe(5).has_value());
+    EXPECT_TRUE(tt.probe(6).has_value());
+    EXPECT_TRUE(tt.probe(7).has_value());
+}
+
+TEST(TestTranspositionTable, TestReplaceSameKey) {
+    TranspositionTable tt { 0 };
+    // a much deeper exact score isn't replaced by a shallow bound
+    tt.store(1, 0, 50, 10, Bound::EXACT);
+    tt.store(1, 0, 20, 2, Bound::LOWER);
+    EXPECT_EQ(10, tt.probe(1)->depth);
+    EXPECT_EQ(Bound::EXACT, tt.probe(1)->bound);
+    // but is by a shallow exact score
+    tt.store(1, 0, 20, 2, Bound::EXACT);
+    EXPECT_EQ(2, tt.probe(1)->depth);
+
+    // a deeper bound is replaced by anything
+    tt.store(2, 0, 50, 10, Bound::UPPER);
+    tt.store(2, 0, 20, 2, Bound::LOWER);
+    EXPECT_EQ(2, tt.probe(2)->depth);
+    EXPECT_EQ(Bound::LOWER, tt.probe(2)->bound);
+}
+
+TEST(TestTranspositionTable, TestHashfull) {
+    TranspositionTable tt { 1, 2 };
+    EXPECT_EQ(0, tt.hashfull());
+    // the sample is the first buckets, fill them through the index the keys map to
+    for (std::uint64_t i = 0; i < 100000; ++i) {
+        tt.store(i * 0x9E3779B97F4A7C15, 0, 0, 1, Bound::EXACT);
+    }
+    EXPECT_GT(tt.hashfull(), 0);
+    tt.new_search();
+    EXPECT_EQ(0, tt.hashfull());
+    tt.resize(2, 2);
+    EXPECT_EQ(2, tt.size_mb());
+    EXPECT_EQ(0, tt.hashfull());
+}
+
+TEST(TestTranspositionTable, TestPackedMove) {
+    const auto board { Board::init() };
+    ASSERT_TRUE(board.has_value());
+    const auto e4 { parse_move_input("e2e4", *board) };
+    const auto d4 { parse_move_input("d2d4", *board) };
+    ASSERT_TRUE(e4.has_value() && d4.has_value());
+    EXPECT_TRUE(matches(pack_move(*e4), *e4));
+    EXPECT_FALSE(matches(pack_move(*e4), *d4));
+    EXPECT_FALSE(matches(0, *e4));
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "attack_table.h"
+#include "uci.h"
+
+#include <chrono>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using namespace std::chrono_literals;
+
+class TestUci : public testing::Test {
+protected:
+    static const AttackTable at;
+
+    // Everything sent in reply to lines, "wait" waits for the search to finish instead of
+    // being sent
+    static std::string session(const std::initializer_list<std::string_view> lines) {
+        std::ostringstream out;
+        {
+            Uci uci { at, out, 1 };
+            for (const auto line : lines) {
+                if (line == "wait") {
+                    uci.wait();
+                } else {
+                    uci.handle(line);
+                }
+            }
+        }
+        return out.str();
+    }
+};
+
+const AttackTable TestUci::at {};
+
+TEST_F(TestUci, TestParseGo) {
+    const auto go { parse_go(" wtime 1000 btime 2000 winc 10 binc 20 movestogo 5 depth 7") };
+    ASSERT_TRUE(go.has_value());
+    EXPECT_EQ(1000ms, go->time[WHITE]);
+    EXPECT_EQ(2000ms, go->time[BLACK]);
+    EXPECT_EQ(10ms, go->increment[WHITE]);
+    EXPECT_EQ(20ms, go->increment[BLACK]);
+    EXPECT_EQ(5, go->moves_to_go);
+    EXPECT_EQ(7, go->limits.depth);
+    EXPECT_FALSE(go->infinite);
+
+    const auto infinite { parse_go("infinite") };
+    ASSERT_TRUE(infinite.has_value());
+    EXPECT_TRUE(infinite->infinite);
+    EXPECT_TRUE(parse_go("ponder nodes 100")->ponder);
+    EXPECT_EQ(100u, parse_go("ponder nodes 100")->limits.nodes);
+    // a run out clock can come through negative
+    EXPECT_EQ(0ms, parse_go("wtime -20")->time[WHITE]);
+
+    EXPECT_FALSE(parse_go("depth").has_value());
+    EXPECT_FALSE(parse_go("depth x").has_value());
+    EXPECT_FALSE(parse_go("sideways 3").has_value());
+}
+
+TEST_F(TestUci, TestSearchLimits) {
+    // movetime is used as it is
+    EXPECT_EQ(300ms, search_limits(*parse_go("wtime 10000 movetime 300"), WHITE).time);
+    // otherwise it's a share of the side to move's clock plus most of the increment
+    EXPECT_EQ(100ms, search_limits(*parse_go("wtime 1000 btime 3000 movestogo 10"), WHITE).time);
+    EXPECT_EQ(525ms, search_limits(*parse_go("wtime 1000 btime 3000 binc 300 movestogo 10"),
+                                   BLACK).time);
+    // but never all of what's left
+    EXPECT_LT(search_limits(*parse_go("wtime 100 movestogo 1"), WHITE).time, 100ms);
+    EXPECT_GT(search_limits(*parse_go("wtime 10 movestogo 1"), WHITE).time, 0ms);
+    EXPECT_EQ(0ms, search_limits(*parse_go("wtime 1000 infinite"), WHITE).time);
+    EXPECT_EQ(0ms, search_limits(*parse_go("depth 5"), WHITE).time);
+}
+
+TEST_F(TestUci, TestHandshake) {
+    const std::string out { session({ "uci", "isready", "quit" }) };
+    EXPECT_NE(std::string::npos, out.find("id name Fenrir\n"));
+    EXPECT_NE(std::string::npos, out.find("option name Hash type spin default 1 "));
+    EXPECT_NE(std::string::npos, out.find("uciok\nreadyok\n"));
+}
+
+TEST_F(TestUci, TestGo) {
+    const std::string out {
+        session({ "setoption name Threads value 2", "position startpos moves e2e4 e7e5",
+                  "go depth 3", "wait" })
+    };
+    EXPECT_NE(std::string::npos, out.find("info depth 3 score cp "));
+    EXPECT_NE(std::string::npos, out.find("\nbestmove "));
+    // and it's the last thing sent
+    EXPECT_EQ(out.rfind("\nbestmove "), out.rfind('\n', out.size() - 2));
+}
+
+TEST_F(TestUci, TestStop) {
+    // the stop can come before the search has even started
+    const std::string out { session({ "position startpos", "go infinite", "stop", "wait" }) };
+    EXPECT_NE(std::string::npos, out.find("bestmove "));
+}
+
+TEST_F(TestUci, TestPonderhit) {
+    // a finished ponder search holds on to its move until the ponderhit
+    const std::string out {
+        session({ "position startpos", "go ponder depth 1", "ponderhit", "wait" })
+    };
+    EXPECT_NE(std::string::npos, out.find("bestmove "));
+}
+
+TEST_F(TestUci, TestPosition) {
+    // checkmated
+    const std::string mated { "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3" };
+    EXPECT_NE(std::string::npos,
+              session({ "position fen " + mated, "go depth 2", "wait" }).find("bestmove 0000\n"));
+    // an illegal move is left off along with the rest, so it's black to move
+    EXPECT_NE(std::string::npos,
+              session({ "position fen 4k3/8/8/8/8/8/8/R3K3 w - - 0 1 moves e1e2 e8e9 a1a8",
+                        "go depth 1", "wait" }).find("bestmove e8"));
+
+    // longer than Board's history, the shuffling knights are a draw by repetition
+    std::string shuffle { "position startpos moves" };
+    for (int i = 0; i < 100; ++i) {
+        shuffle += " g1f3 g8f6 f3g1 f6g8";
+    }
+    shuffle += " e2e4";
+    const std::string out { session({ shuffle, "go depth 4", "wait" }) };
+    EXPECT_NE(std::string::npos, out.find("bestmove "));
+}